@@ -7,14 +7,16 @@
 
 #include "DependencyInstance.h"
 #include "util/Constant.h"
-#include <boost/regex.hpp>
 #include "util/StringUtils.h"
 #include <float.h>
+#include <string.h>
+#include <math.h>
 #include "util/Logarithm.h"
+#include "util/SerializationUtils.h"
 
 namespace segparser {
 
-DependencyInstance::DependencyInstance() : numWord(-1) {
+DependencyInstance::DependencyInstance() : numWord(-1), dictKey(0) {
 }
 
 DependencyInstance::~DependencyInstance() {
@@ -77,11 +79,57 @@ HeadIndex DependencyInstance::segToWord(int id) {
 	}
 }
 
-bool DependencyInstance::isPunc(string& w) {
-	return boost::regex_match(w, boost::regex("[-!\"#%&'()*,./:;?@\\[\\]_{}、]+"));
+// byte table for isPunc. Same as matching the (byte-wise) regex
+// [-!"#%&'()*,./:;?@\[\]_{}、]+, so the three utf-8 bytes of 、 count
+// as punctuation on their own
+struct PuncTable {
+	bool punc[256];
+
+	PuncTable() {
+		memset(punc, 0, sizeof(punc));
+		const char* chars = "-!\"#%&'()*,./:;?@[]_{}、";
+		for (const char* c = chars; *c; ++c)
+			punc[(unsigned char)*c] = true;
+	}
+};
+
+static const PuncTable puncTable;
+
+bool DependencyInstance::isPunc(const string& w) {
+	if (w.empty())
+		return false;
+	for (unsigned int i = 0; i < w.size(); ++i)
+		if (!puncTable.punc[(unsigned char)w[i]])
+			return false;
+	return true;
+}
+
+static inline bool isDigit(char c) {
+	return c >= '0' && c <= '9';
 }
 
-bool DependencyInstance::isCoord(int lang, string& w) {
+// same as matching (-*)([0-9]+|[0-9]+\.[0-9]+|[0-9]+[0-9,]+)
+bool DependencyInstance::isNumber(const string& s) {
+	unsigned int i = 0;
+	while (i < s.size() && s[i] == '-')
+		i++;
+	if (i >= s.size() || !isDigit(s[i]))
+		return false;
+	while (i < s.size() && isDigit(s[i]))
+		i++;
+	if (i < s.size() && s[i] == '.') {
+		// a decimal number
+		unsigned int st = ++i;
+		while (i < s.size() && isDigit(s[i]))
+			i++;
+		return i > st && i == s.size();
+	}
+	while (i < s.size() && (isDigit(s[i]) || s[i] == ','))
+		i++;
+	return i == s.size();
+}
+
+bool DependencyInstance::isCoord(int lang, const string& w) {
 	switch (lang) {
 		case PossibleLang::Arabic:
 			if (/*w.compare("w") == 0 || */w.compare(">w") == 0/* || w.compare(">n") == 0*/)
@@ -113,7 +161,7 @@ string DependencyInstance::normalize(string s) {
 		s = "(";
 	else if (s.compare("-RRB-") == 0)
 		s = ")";
-	if (boost::regex_match(s, boost::regex("(-*)([0-9]+|[0-9]+\\.[0-9]+|[0-9]+[0-9,]+)")))
+	if (isNumber(s))
 		s = "<num>";
 	return s;
 }
@@ -168,6 +216,18 @@ void DependencyInstance::setInstIds(DependencyPipe* pipe, Options* options) {
 	Alphabet* lexAlphabet = pipe->lexAlphabet;
 	unordered_map<string, string>& coarseMap = pipe->coarseMap;
 
+	if (dictKey != 0) {
+		// loaded from a compiled corpus
+		if (dictKey == pipe->dictKey)
+			return;
+
+		// compiled with other dictionaries, resolve again from the strings
+		for (int i = 0; i < numWord; ++i)
+			for (unsigned int j = 0; j < word[i].candSeg.size(); ++j)
+				word[i].candSeg[j].morphid.clear();
+		dictKey = 0;
+	}
+
 	if (options->lang == PossibleLang::Chinese) {
 		int len = 0;
 		for (int i = 1; i < numWord; ++i) {
@@ -399,4 +459,148 @@ void DependencyInstance::output() {
 	cin >> x;
 }
 
+static void writeHeadIndex(FILE* fs, const HeadIndex& id) {
+	CHECK(WriteInteger(fs, id.hWord));
+	CHECK(WriteInteger(fs, id.hSeg));
+}
+
+static void readHeadIndex(FILE* fs, HeadIndex& id) {
+	CHECK(ReadInteger(fs, &id.hWord));
+	CHECK(ReadInteger(fs, &id.hSeg));
+}
+
+static void writeSymbol(FILE* fs, const Symbol& s) {
+	CHECK(WriteString(fs, s));
+}
+
+static void readSymbol(FILE* fs, SymbolTable* symbols, Symbol& s) {
+	string str;
+	CHECK(ReadString(fs, &str));
+	s = symbols->intern(str);
+}
+
+static void writeSymbolArray(FILE* fs, const vector<Symbol>& arr) {
+	CHECK(WriteInteger(fs, arr.size()));
+	for (unsigned int i = 0; i < arr.size(); ++i)
+		writeSymbol(fs, arr[i]);
+}
+
+static void readSymbolArray(FILE* fs, SymbolTable* symbols, vector<Symbol>& arr) {
+	int size = 0;
+	CHECK(ReadInteger(fs, &size));
+	arr.resize(size);
+	for (int i = 0; i < size; ++i)
+		readSymbol(fs, symbols, arr[i]);
+}
+
+void DependencyInstance::writeObject(FILE* fs) {
+	// child lists, conversion lists and counts are rebuilt after reading
+	CHECK(WriteInteger(fs, numWord));
+	CHECK(WriteIntegerArray(fs, characterid));
+
+	for (int i = 0; i < numWord; ++i) {
+		WordInstance& w = word[i];
+		writeSymbolArray(fs, w.goldForm);
+		writeSymbolArray(fs, w.goldLemma);
+		writeSymbolArray(fs, w.goldPos);
+		CHECK(WriteInteger(fs, w.goldAlIndex));
+		CHECK(WriteInteger(fs, w.goldMorphIndex));
+		writeSymbolArray(fs, w.goldMorph);
+		CHECK(WriteInteger(fs, w.goldDep.size()));
+		for (unsigned int j = 0; j < w.goldDep.size(); ++j)
+			writeHeadIndex(fs, w.goldDep[j]);
+		writeSymbolArray(fs, w.goldLab);
+		writeSymbol(fs, w.wordStr);
+		CHECK(WriteInteger(fs, w.wordid));
+		CHECK(WriteInteger(fs, w.currSegCandID));
+
+		CHECK(WriteInteger(fs, w.candSeg.size()));
+		for (unsigned int j = 0; j < w.candSeg.size(); ++j) {
+			SegInstance& seg = w.candSeg[j];
+			writeSymbol(fs, seg.segStr);
+			CHECK(WriteDouble(fs, seg.prob));
+			CHECK(WriteInteger(fs, seg.AlIndex));
+			CHECK(WriteInteger(fs, seg.morphIndex));
+			writeSymbolArray(fs, seg.morph);
+			CHECK(WriteIntegerArray(fs, seg.morphid));
+
+			CHECK(WriteInteger(fs, seg.element.size()));
+			for (int k = 0; k < seg.size(); ++k) {
+				SegElement& ele = seg.element[k];
+				writeSymbol(fs, ele.form);
+				CHECK(WriteInteger(fs, ele.formid));
+				writeSymbol(fs, ele.lemma);
+				CHECK(WriteInteger(fs, ele.lemmaid));
+				writeHeadIndex(fs, ele.dep);
+				CHECK(WriteInteger(fs, ele.labid));
+				CHECK(WriteInteger(fs, ele.currPosCandID));
+				writeSymbolArray(fs, ele.candPos);
+				CHECK(WriteIntegerArray(fs, ele.candPosid));
+				CHECK(WriteIntegerArray(fs, ele.candDetPosid));
+				CHECK(WriteIntegerArray(fs, ele.candSpecialPos));
+				CHECK(WriteDoubleArray(fs, ele.candProb));
+				CHECK(WriteInteger(fs, ele.st));
+				CHECK(WriteInteger(fs, ele.en));
+			}
+		}
+	}
+}
+
+void DependencyInstance::readObject(FILE* fs, SymbolTable* symbols) {
+	CHECK(ReadInteger(fs, &numWord));
+	CHECK(ReadIntegerArray(fs, &characterid));
+
+	int size = 0;
+	word.resize(numWord);
+	for (int i = 0; i < numWord; ++i) {
+		WordInstance& w = word[i];
+		readSymbolArray(fs, symbols, w.goldForm);
+		readSymbolArray(fs, symbols, w.goldLemma);
+		readSymbolArray(fs, symbols, w.goldPos);
+		CHECK(ReadInteger(fs, &w.goldAlIndex));
+		CHECK(ReadInteger(fs, &w.goldMorphIndex));
+		readSymbolArray(fs, symbols, w.goldMorph);
+		CHECK(ReadInteger(fs, &size));
+		w.goldDep.resize(size);
+		for (int j = 0; j < size; ++j)
+			readHeadIndex(fs, w.goldDep[j]);
+		readSymbolArray(fs, symbols, w.goldLab);
+		readSymbol(fs, symbols, w.wordStr);
+		CHECK(ReadInteger(fs, &w.wordid));
+		CHECK(ReadInteger(fs, &w.currSegCandID));
+
+		CHECK(ReadInteger(fs, &size));
+		w.candSeg.resize(size);
+		for (unsigned int j = 0; j < w.candSeg.size(); ++j) {
+			SegInstance& seg = w.candSeg[j];
+			readSymbol(fs, symbols, seg.segStr);
+			CHECK(ReadDouble(fs, &seg.prob));
+			CHECK(ReadInteger(fs, &seg.AlIndex));
+			CHECK(ReadInteger(fs, &seg.morphIndex));
+			readSymbolArray(fs, symbols, seg.morph);
+			CHECK(ReadIntegerArray(fs, &seg.morphid));
+
+			CHECK(ReadInteger(fs, &size));
+			seg.element.resize(size);
+			for (int k = 0; k < seg.size(); ++k) {
+				SegElement& ele = seg.element[k];
+				readSymbol(fs, symbols, ele.form);
+				CHECK(ReadInteger(fs, &ele.formid));
+				readSymbol(fs, symbols, ele.lemma);
+				CHECK(ReadInteger(fs, &ele.lemmaid));
+				readHeadIndex(fs, ele.dep);
+				CHECK(ReadInteger(fs, &ele.labid));
+				CHECK(ReadInteger(fs, &ele.currPosCandID));
+				readSymbolArray(fs, symbols, ele.candPos);
+				CHECK(ReadIntegerArray(fs, &ele.candPosid));
+				CHECK(ReadIntegerArray(fs, &ele.candDetPosid));
+				CHECK(ReadIntegerArray(fs, &ele.candSpecialPos));
+				CHECK(ReadDoubleArray(fs, &ele.candProb));
+				CHECK(ReadInteger(fs, &ele.st));
+				CHECK(ReadInteger(fs, &ele.en));
+			}
+		}
+	}
+}
+
 } /* namespace segparser */
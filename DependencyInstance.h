@@ -10,9 +10,13 @@
 
 #include <vector>
 #include <string>
+#include <iostream>
 #include <boost/shared_ptr.hpp>
 #include <unordered_set>
+#include <stdio.h>
+#include <stdint.h>
 #include "util/FeatureVector.h"
+#include "util/Symbol.h"
 
 namespace segparser {
 
@@ -54,9 +58,9 @@ public:
 
 class SegElement {
 public:
-	string form;
+	Symbol form;
 	int formid;
-	string lemma;
+	Symbol lemma;
 	int lemmaid;
 
 	HeadIndex dep;
@@ -65,7 +69,7 @@ public:
 	vector<HeadIndex> child;
 
 	int currPosCandID;			// id of the pos in candidate list
-	vector<string> candPos;
+	vector<Symbol> candPos;
 	vector<int> candPosid;
 	vector<int> candDetPosid;
 	vector<int> candSpecialPos;
@@ -75,7 +79,7 @@ public:
 	int st;
 	int en;
 
-	SegElement() : form(""), formid(-1), lemma(""), lemmaid(-1), labid(-1), currPosCandID(-1), st(-1), en(-1) {}
+	SegElement() : formid(-1), lemmaid(-1), labid(-1), currPosCandID(-1), st(-1), en(-1) {}
 
 	int candPosNum() {
 		return candPos.size();
@@ -108,16 +112,16 @@ public:
 class SegInstance {
 public:
 	vector<SegElement> element;
-	string segStr;
+	Symbol segStr;
 	double prob;
 
 	// morphology features
 	int AlIndex;
 	int morphIndex;
-	vector<string> morph;		//per/gen/num
+	vector<Symbol> morph;		//per/gen/num
 	vector<int> morphid;
 
-	SegInstance() : segStr(""), prob(0.0), AlIndex(-1), morphIndex(-1) {}
+	SegInstance() : prob(0.0), AlIndex(-1), morphIndex(-1) {}
 
 	int size() {
 		return element.size();
@@ -135,18 +139,18 @@ class WordInstance {
 public:
 	// form/pos/dep/lab are retrieved from the candidate and id
 	// the following are just for temporarily record gold info
-	vector<string> goldForm;
-	vector<string> goldLemma;
-	vector<string> goldPos;
+	vector<Symbol> goldForm;
+	vector<Symbol> goldLemma;
+	vector<Symbol> goldPos;
 
 	int goldAlIndex;
 	int goldMorphIndex;
-	vector<string> goldMorph;
+	vector<Symbol> goldMorph;
 
 	vector<HeadIndex> goldDep;
-	vector<string> goldLab;
+	vector<Symbol> goldLab;
 
-	string wordStr;
+	Symbol wordStr;
 	int wordid;
 
 	int currSegCandID;		// id of the seg in candidate list
@@ -158,7 +162,6 @@ public:
 	vector< vector<int> > outMap;		// [a->b id][size of a], for each child of a, need a map to decide its new parent
 
 	WordInstance() {
-		wordStr = "";
 		wordid = -1;
 		goldAlIndex = -1;
 		goldMorphIndex = -1;
@@ -196,6 +199,8 @@ public:
 
 	FeatureVector fv;		// feature vector of the current tree
 
+	uint64_t dictKey;		// key of the dictionaries the ids were resolved with, 0 if unknown
+
 	// word index and seg index conversion
 	void constructConversionList();
 	void setOptSegPosCount();
@@ -215,13 +220,17 @@ public:
 	void updateChildList(HeadIndex& newH, HeadIndex& oldH, HeadIndex& arg);
 
 	void output();
+
+	void writeObject(FILE* fs);
+	void readObject(FILE* fs, SymbolTable* symbols);		// the strings are interned in symbols
 private:
 	vector<int> numSeg;		// total number of segs before this word, appending the total number in the end
 							// size = number of words
 	vector<int> seg2Word;	// word index for the segment, size = number of segs
 
-	bool isPunc(string& w);
-	bool isCoord(int lang, string& w);
+	bool isPunc(const string& w);
+	static bool isNumber(const string& s);
+	bool isCoord(int lang, const string& w);
 
 	int computeOverlap(SegElement& e1, SegElement& e2);
 	vector<int> buildInMap(WordInstance& w, int a, int b);
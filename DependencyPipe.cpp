@@ -6,33 +6,56 @@
  */
 
 #include "DependencyPipe.h"
+#include "Parameters.h"
 #include "util/Constant.h"
 #include <assert.h>
 #include "util/StringUtils.h"
 #include "io/DependencyReader.h"
 #include "util/Random.h"
+#include "util/SerializationUtils.h"
+#include <algorithm>
 
 namespace segparser {
 
 DependencyPipe::DependencyPipe(Options* options)
-	: options(options) {
+	: dictKey(0), options(options) {
 	dataAlphabet = new FeatureAlphabet(300000);
 	typeAlphabet = new Alphabet(100);
 	posAlphabet = new Alphabet(100);
 	lexAlphabet = new Alphabet(30000);
+	sharedDictionaries = false;
+	if (options->hashBits > 0)
+		dataAlphabet->useHashKernel(options->hashBits);
 
 	fe = new FeatureEncoder();
 }
 
 DependencyPipe::~DependencyPipe() {
 	delete dataAlphabet;
-	delete typeAlphabet;
-	delete posAlphabet;
-	delete lexAlphabet;
+	if (!sharedDictionaries) {
+		delete typeAlphabet;
+		delete posAlphabet;
+		delete lexAlphabet;
+	}
 
 	delete fe;
 }
 
+void DependencyPipe::shareDictionaries(DependencyPipe* pipe) {
+	// use the dictionaries of pipe, so that both resolve the same ids.
+	// pipe has to outlive this one
+	if (!sharedDictionaries) {
+		delete typeAlphabet;
+		delete posAlphabet;
+		delete lexAlphabet;
+	}
+	typeAlphabet = pipe->typeAlphabet;
+	posAlphabet = pipe->posAlphabet;
+	lexAlphabet = pipe->lexAlphabet;
+	sharedDictionaries = true;
+	dictKey = pipe->dictKey;
+}
+
 void DependencyPipe::loadCoarseMap(string& file) {
 	int p = file.find("/data/");
 	string path = file.substr(0, p + 6);
@@ -88,15 +111,45 @@ void DependencyPipe::setAndCheckOffset() {
 }
 
 void DependencyPipe::closeAlphabets() {
+	if (options->featureCutoff > 1) {
+		int removed = dataAlphabet->removeRare(options->featureCutoff);
+		if (removed > 0)
+			cout << "removed " << removed << " features seen less than " << options->featureCutoff << " times" << endl;
+	}
 	dataAlphabet->stopGrowth();
 	typeAlphabet->stopGrowth();
 	posAlphabet->stopGrowth();
 	lexAlphabet->stopGrowth();
 
-	cout << "arc alphabet: " << dataAlphabet->arcMap.size() << endl;
-	cout << "second order alphabet: " << dataAlphabet->secondOrderMap.size() << endl;
-	cout << "third order alphabet: " << dataAlphabet->thirdOrderMap.size() << endl;
-	cout << "high order alphabet: " << dataAlphabet->highOrderMap.size() << endl;
+	updateDictionaryKey();
+
+	if (dataAlphabet->isHashed()) {
+		cout << "hash kernel features: " << dataAlphabet->size() - 1 << endl;
+		return;
+	}
+
+	cout << "arc alphabet: " << dataAlphabet->tableSize(TemplateType::TArc) << endl;
+	cout << "second order alphabet: " << dataAlphabet->tableSize(TemplateType::TSecondOrder) << endl;
+	cout << "third order alphabet: " << dataAlphabet->tableSize(TemplateType::TThirdOrder) << endl;
+	cout << "high order alphabet: " << dataAlphabet->tableSize(TemplateType::THighOrder) << endl;
+}
+
+void DependencyPipe::updateDictionaryKey() {
+	// everything setInstIds depends on
+	vector<string> coarse;
+	for (auto kv : coarseMap)
+		coarse.push_back(kv.first + "\t" + kv.second);
+	sort(coarse.begin(), coarse.end());
+	Alphabet coarseAlphabet(coarse.size());
+	for (unsigned int i = 0; i < coarse.size(); ++i)
+		coarseAlphabet.lookupIndex(coarse[i]);
+
+	uint64_t key = options->lang;
+	key = key * 1099511628211ULL ^ typeAlphabet->fingerprint();
+	key = key * 1099511628211ULL ^ posAlphabet->fingerprint();
+	key = key * 1099511628211ULL ^ lexAlphabet->fingerprint();
+	key = key * 1099511628211ULL ^ coarseAlphabet.fingerprint();
+	dictKey = (key == 0 ? 1 : key);
 }
 
 void DependencyPipe::buildSuffixList() {
@@ -124,6 +177,54 @@ void DependencyPipe::buildSuffixList() {
 }
 
 void DependencyPipe::buildDictionary(string& goldfile) {
+	DependencyReader reader(options, goldfile);
+	if (!options->jointSegPos)
+		reader.hasCandidate = false;
+	reader.isTrain = true;
+
+	startDictionary(reader);
+
+	if (!reader.isCompiled()) {
+		// stream the corpus, only one instance is kept in memory
+		inst_ptr gold = reader.nextInstance();
+		int cnt = 0;
+		while (gold && cnt < options->trainSentences) {
+			if ((cnt + 1) % 1000 == 0) {
+				cout << (cnt + 1) << "  ";
+				cout.flush();
+			}
+
+			gold->setInstIds(this, options);
+			cnt++;
+			gold = reader.nextInstance();
+		}
+	}
+	reader.close();
+
+	cout << "Done." << endl;
+
+	setAndCheckOffset();
+}
+
+void DependencyPipe::buildDictionary(DependencyReader& reader, vector<inst_ptr>& corpus) {
+	startDictionary(reader);
+
+	int num = min((int)corpus.size(), options->trainSentences);
+	for (int cnt = 0; cnt < num; ++cnt) {
+		if ((cnt + 1) % 1000 == 0) {
+			cout << (cnt + 1) << "  ";
+			cout.flush();
+		}
+
+		corpus[cnt]->setInstIds(this, options);
+	}
+
+	cout << "Done." << endl;
+
+	setAndCheckOffset();
+}
+
+void DependencyPipe::startDictionary(DependencyReader& reader) {
 	cout << "Creating Dictionary ... ";
 	cout.flush();
 
@@ -143,121 +244,143 @@ void DependencyPipe::buildDictionary(string& goldfile) {
 
 	buildSuffixList();
 
+	if (reader.isCompiled()) {
+		// dictionaries are stored in the compiled corpus
+		reader.readDictionary(typeAlphabet, posAlphabet, lexAlphabet);
+		updateDictionaryKey();
+	}
+}
+
+void DependencyPipe::createAlphabet(string& goldfile) {
+
+	buildDictionary(goldfile);
+
+	if (dataAlphabet->isHashed()) {
+		// nothing to collect, the features are hashed
+		closeAlphabets();
+		return;
+	}
+
+	cout << "Creating Alphabet ... ";
+	cout.flush();
+
 	DependencyReader reader(options, goldfile);
 	if (!options->jointSegPos)
 		reader.hasCandidate = false;
 	reader.isTrain = true;
 
 	inst_ptr gold = reader.nextInstance();
-
 	int cnt = 0;
-
-	while (gold) {
+	while (gold && cnt < options->trainSentences) {
 		if ((cnt + 1) % 1000 == 0) {
 			cout << (cnt + 1) << "  ";
 			cout.flush();
 		}
 
 		gold->setInstIds(this, options);
+		FeatureVector fv;
+		createFeatureVector(gold.get(), &fv);
 		cnt++;
-		if (cnt >= options->trainSentences)
-			break;
 		gold = reader.nextInstance();
 	}
 	reader.close();
 
 	cout << "Done." << endl;
 
-	setAndCheckOffset();
+	closeAlphabets();
 }
 
-void DependencyPipe::createAlphabet(string& goldfile) {
-
-	buildDictionary(goldfile);
+void DependencyPipe::createAlphabet(vector<inst_ptr>& corpus) {
 
 	cout << "Creating Alphabet ... ";
 	cout.flush();
 
-	DependencyReader reader(options, goldfile);
-	if (!options->jointSegPos)
-		reader.hasCandidate = false;
-	reader.isTrain = true;
-
-	inst_ptr gold = reader.nextInstance();
-
-	int cnt = 0;
-
-	while (gold) {
+	// ids are already set by buildDictionary
+	int num = min((int)corpus.size(), options->trainSentences);
+	for (int cnt = 0; cnt < num; ++cnt) {
 		if ((cnt + 1) % 1000 == 0) {
 			cout << (cnt + 1) << "  ";
 			cout.flush();
 		}
 
-		gold->setInstIds(this, options);
-		createFeatureVector(gold.get(), &(gold->fv));
-
-		cnt++;
-		if (cnt >= options->trainSentences)
-			break;
-
-		gold = reader.nextInstance();
-
+		createFeatureVector(corpus[cnt].get(), &(corpus[cnt]->fv));
 	}
 
 	cout << "Done." << endl;
 
 	closeAlphabets();
 
-	reader.close();
+	if (options->featureCutoff > 1) {
+		// the vectors have the indices from before the cutoff
+		for (int cnt = 0; cnt < num; ++cnt) {
+			corpus[cnt]->fv.clear();
+			createFeatureVector(corpus[cnt].get(), &(corpus[cnt]->fv));
+		}
+	}
 }
 
 vector<inst_ptr> DependencyPipe::createInstances(string goldFile) {
 
-	createAlphabet(goldFile);
-
-	cout << "Num Features: " << dataAlphabet->size() - 1 << endl;
-    cout << "Num Edge Labels: " << typeAlphabet->size() - 1 << endl;
-
-	vector<inst_ptr> trainData;
-
-	cout << "Creating Instances: ... ";
-	cout.flush();
-
+	// read the corpus once, the dictionary, the alphabet and the
+	// gold feature vectors are all built from the parsed instances
 	DependencyReader reader(options, goldFile);
 	if (!options->jointSegPos)
 		reader.hasCandidate = false;
 	reader.isTrain = true;
 
+	vector<inst_ptr> corpus;
 	inst_ptr gold = reader.nextInstance();
 
 	int num1 = 0;
 	while (gold) {
-		if ((num1 + 1) % 1000 == 0) {
-			cout << (num1 + 1) << "  ";
+		corpus.push_back(gold);
+		if (gold->getNumSeg() - 1 <= options->maxLength) {
+			num1++;
+			if (num1 >= options->trainSentences)
+				break;
+		}
+		gold = reader.nextInstance();
+	}
+
+	buildDictionary(reader, corpus);
+	corpusSymbols = reader.symbols;
+	reader.close();
+
+	createAlphabet(corpus);
+
+	cout << "Num Features: " << dataAlphabet->size() - 1 << endl;
+    cout << "Num Edge Labels: " << typeAlphabet->size() - 1 << endl;
+
+	vector<inst_ptr> trainData;
+
+	cout << "Creating Instances: ... ";
+	cout.flush();
+
+	for (unsigned int i = 0; i < corpus.size(); ++i) {
+		if ((trainData.size() + 1) % 1000 == 0) {
+			cout << (trainData.size() + 1) << "  ";
 			cout.flush();
 		}
 
+		gold = corpus[i];
 		if (gold->getNumSeg() - 1 > options->maxLength) {
 			cout << "too long: " << gold->getNumSeg() - 1<< endl;
 		}
 		else {
-			gold->setInstIds(this, options);
-			createFeatureVector(gold.get(), &(gold->fv));
+			if ((int)i >= options->trainSentences) {
+				// not seen by createAlphabet
+				gold->setInstIds(this, options);
+				createFeatureVector(gold.get(), &(gold->fv));
+			}
 			trainData.push_back(gold);
-			num1++;
-			if (num1 >= options->trainSentences)
-				break;
 		}
-
-		gold = reader.nextInstance();
+		corpus[i].reset();
 	}
 	//gold->output();
 	//gold->fv.output();
 
 	cout << "Done." << endl;
 
-	reader.close();
-
 	if (options->lang == PossibleLang::Chinese) {
 		// shuffle data for Chinese
 		vector<inst_ptr> ret;
@@ -286,6 +409,68 @@ vector<inst_ptr> DependencyPipe::createInstances(string goldFile) {
 	}
 }
 
+void DependencyPipe::compileCorpus(string file, string outFile, bool isTrain) {
+	// write instances with resolved ids, so that later runs can skip
+	// parsing the lattice and setInstIds
+	cout << "Compiling " << file << " to " << outFile << " ... ";
+	cout.flush();
+
+	// the stored ids are only valid for the final dictionaries
+	typeAlphabet->stopGrowth();
+	posAlphabet->stopGrowth();
+	lexAlphabet->stopGrowth();
+	updateDictionaryKey();
+
+	DependencyReader reader(options, file);
+	if (!options->jointSegPos)
+		reader.hasCandidate = false;
+	reader.isTrain = isTrain;
+
+	FILE *fs = fopen(outFile.c_str(), "wb");
+	if (!fs)
+		ThrowException("cannot open " + outFile);
+
+	CHECK(WriteInteger(fs, COMPILED_CORPUS_MAGIC));
+	CHECK(WriteInteger(fs, COMPILED_CORPUS_VERSION));
+	CHECK(WriteBool(fs, reader.hasCandidate));
+	CHECK(WriteBool(fs, reader.isTrain));
+	CHECK(WriteUINT64(fs, dictKey));
+	long offsetPos = ftell(fs);
+	CHECK(WriteUINT64(fs, 0));		// offset of the instances, filled below
+
+	typeAlphabet->writeObject(fs);
+	posAlphabet->writeObject(fs);
+	lexAlphabet->writeObject(fs);
+
+	uint64_t dataOffset = ftell(fs);
+	fseek(fs, offsetPos, SEEK_SET);
+	CHECK(WriteUINT64(fs, dataOffset));
+	fseek(fs, dataOffset, SEEK_SET);
+
+	inst_ptr inst = reader.nextInstance();
+
+	int cnt = 0;
+	while (inst) {
+		if ((cnt + 1) % 1000 == 0) {
+			cout << (cnt + 1) << "  ";
+			cout.flush();
+		}
+
+		inst->setInstIds(this, options);
+		CHECK(WriteBool(fs, true));
+		inst->writeObject(fs);
+		cnt++;
+
+		inst = reader.nextInstance();
+	}
+	CHECK(WriteBool(fs, false));
+
+	fclose(fs);
+	reader.close();
+
+	cout << cnt << " instances. Done." << endl;
+}
+
 int DependencyPipe::findRightNearestChildID(vector<HeadIndex>& child, HeadIndex id) {
 	unsigned int ret = 0;
 	for (; ret < child.size(); ++ret)
@@ -1838,12 +2023,30 @@ void DependencyPipe::createPartialPosHighOrderFeatureVector(DependencyInstance*
 }
 
 void DependencyPipe::addCode(int type, uint64_t code, double val, FeatureVector* fv) {
+	if (dataAlphabet->isHashed()) {
+		int feat = dataAlphabet->hashIndex(type, code);
+		if (feat > 0)
+			fv->add(feat, val);
+		else
+			fv->add(-feat, -val);
+		return;
+	}
+
 	int feat = dataAlphabet->lookupIndex(type, code, true);
 	if (feat > 0)
 		fv->add(feat, val);
 }
 
 void DependencyPipe::addCode(int type, uint64_t code, FeatureVector* fv) {
+	if (dataAlphabet->isHashed()) {
+		int feat = dataAlphabet->hashIndex(type, code);
+		if (feat > 0)
+			fv->addBinary(feat);
+		else
+			fv->addNegBinary(-feat);
+		return;
+	}
+
 	int feat = dataAlphabet->lookupIndex(type, code, true);
 	if (feat > 0)
 		fv->addBinary(feat);
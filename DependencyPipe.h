@@ -18,6 +18,8 @@ namespace segparser {
 
 using namespace std;
 
+class DependencyReader;
+
 class DependencyPipe {
 public:
 	DependencyPipe(Options* options);
@@ -26,10 +28,16 @@ public:
 	void loadCoarseMap(string& file);
 	void setAndCheckOffset();
 	void buildDictionary(string& goldfile);
+	void buildDictionary(DependencyReader& reader, vector<inst_ptr>& corpus);
+	void startDictionary(DependencyReader& reader);
 	void buildDictionaryWithOOV(string& goldfile);
 	void closeAlphabets();
 	void createAlphabet(string& goldfile);
+	void createAlphabet(vector<inst_ptr>& corpus);
 	vector<inst_ptr> createInstances(string goldFile);
+	void updateDictionaryKey();
+	void compileCorpus(string file, string outFile, bool isTrain);
+	void shareDictionaries(DependencyPipe* pipe);
 
 	int findRightNearestChildID(vector<HeadIndex>& child, HeadIndex id);
 	HeadIndex findRightNearestChild(vector<HeadIndex>& child, HeadIndex id);
@@ -59,10 +67,15 @@ public:
 	Alphabet* typeAlphabet;
 	Alphabet* posAlphabet;			// pos
 	Alphabet* lexAlphabet;			// lemma, word
+	bool sharedDictionaries;		// the three dictionaries belong to another pipe
 	unordered_set<string> suffixList;
 
 	unordered_map<string, string> coarseMap;
 
+	uint64_t dictKey;				// fingerprint of the dictionaries and coarse map, 0 if not final
+
+	boost::shared_ptr<SymbolTable> corpusSymbols;		// strings of the instances from createInstances
+
 	// encoder
 	FeatureEncoder* fe;
 private:
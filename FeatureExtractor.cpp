@@ -12,10 +12,11 @@
 #include <algorithm>
 #include <functional>
 #include <array>
+#include <boost/make_shared.hpp>
 
 namespace segparser {
 
-CacheTable::CacheTable() {
+CacheTable::CacheTable() : arena(new Arena()) {
 }
 
 CacheTable::~CacheTable() {
@@ -127,6 +128,7 @@ PrunerFeatureExtractor::PrunerFeatureExtractor() {
 
 void PrunerFeatureExtractor::init(DependencyInstance* inst, SegParser* pruner, int thread) {
 	this->thread = thread;
+	scoreOnly = true;
 	pipe = pruner->pipe;
 	parameters = pruner->parameters;
 	options = pruner->options;
@@ -190,11 +192,11 @@ void PrunerFeatureExtractor::prune(DependencyInstance* inst, HeadIndex& m, vecto
 	ele.dep = oldDep;
 }
 
-FeatureExtractor::FeatureExtractor() {
+FeatureExtractor::FeatureExtractor() : scoreOnly(false), arena(new Arena()) {
 }
 
-FeatureExtractor::FeatureExtractor(DependencyInstance* inst, SegParser* parser, Parameters* params, int thread)
-	: thread(thread), pipe(parser->pipe), parameters(params), pruner(parser->pruner), options(parser->options){
+FeatureExtractor::FeatureExtractor(DependencyInstance* inst, SegParser* parser, Parameters* params, int thread, bool scoreOnly)
+	: thread(thread), scoreOnly(scoreOnly), pipe(parser->pipe), parameters(params), pruner(parser->pruner), arena(new Arena()), options(parser->options){
 	numWord = inst->numWord;
 	type = pipe->typeAlphabet->size();
 
@@ -211,6 +213,21 @@ FeatureExtractor::FeatureExtractor(DependencyInstance* inst, SegParser* parser,
 FeatureExtractor::~FeatureExtractor() {
 }
 
+FeatureVector* FeatureExtractor::scratchVector() {
+	// cleared, but keeps its capacity, so that filling it does not allocate
+	static thread_local FeatureVector fv;
+	fv.clear();
+	return &fv;
+}
+
+item_ptr FeatureExtractor::newCacheItem(FeatureVector* fv, Arena* arena) {
+	item_ptr item = boost::allocate_shared<CacheItem>(ArenaAllocator<CacheItem>(arena));
+	if (!scoreOnly)
+		item->fv.pack(fv, arena);
+	item->score = parameters->getScore(fv);
+	return item;
+}
+
 void FeatureExtractor::constructCacheMap(DependencyInstance* s) {
 	// for optimal seg
 	int size = 1;	// optimal seg and pos
@@ -326,9 +343,9 @@ void FeatureExtractor::initCacheMap(DependencyInstance* s) {
 		for (unsigned int j = 0; j < word.candSeg.size(); ++j) {
 			word.currSegCandID = j;
 			assert(segid == getSeg1OCachePos(i, j));
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			pipe->createSegFeatureVector(s, i, &tmp_ptr->fv);
-			tmp_ptr->score = parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = scratchVector();
+			pipe->createSegFeatureVector(s, i, tmpFv);
+			item_ptr tmp_ptr = newCacheItem(tmpFv, arena.get());
 			seg1o[segid] = tmp_ptr;
 			segid++;
 
@@ -340,9 +357,9 @@ void FeatureExtractor::initCacheMap(DependencyInstance* s) {
 					ele.currPosCandID = l;
 					assert(posid == getPos1OCachePos(i, j, k, l));
 					HeadIndex m(i, k);
-					item_ptr tmp_ptr = item_ptr(new CacheItem());
-					pipe->createPos1OFeatureVector(s, m, &tmp_ptr->fv);
-					tmp_ptr->score = parameters->getScore(&tmp_ptr->fv);
+					FeatureVector* tmpFv = scratchVector();
+					pipe->createPos1OFeatureVector(s, m, tmpFv);
+					item_ptr tmp_ptr = newCacheItem(tmpFv, arena.get());
 					pos1o[posid] = tmp_ptr;
 
 					posid++;
@@ -460,6 +477,7 @@ void FeatureExtractor::setAtomic(int thread) {
 void FeatureExtractor::getArcFvUnsafe(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& h, HeadIndex& m,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread == 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int headIndex = inst->wordToSeg(h);
@@ -472,9 +490,9 @@ void FeatureExtractor::getArcFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 		int pos = id;
 		assert(pos < (int)cache->arc.size());
 		if (!cache->arc[pos]) {
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createArcFeatureVector(inst, h, m, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createArcFeatureVector(inst, h, m, tmpFv);
+			item_ptr tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			cache->arc[pos] = tmp_ptr;
 		}
 		if (fv)
@@ -489,6 +507,7 @@ void FeatureExtractor::getArcFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 void FeatureExtractor::getArcFvAtomic(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& h, HeadIndex& m,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread != 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int headIndex = inst->wordToSeg(h);
@@ -502,9 +521,9 @@ void FeatureExtractor::getArcFvAtomic(FeatureExtractor* fe, DependencyInstance*
 		int pos = id;
 		item_ptr tmp_ptr = atomic_load(&cache->arc[pos]);
 		if (!tmp_ptr) {
-			tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createArcFeatureVector(inst, h, m, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createArcFeatureVector(inst, h, m, tmpFv);
+			tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			atomic_store(&cache->arc[pos], tmp_ptr);
 		}
 		if (fv) {
@@ -538,9 +557,9 @@ double FeatureExtractor::getArcScoreUnsafe(FeatureExtractor* fe, DependencyInsta
 		score += cache->arc[pos]->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createArcFeatureVector(inst, h, m, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createArcFeatureVector(inst, h, m, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -567,9 +586,9 @@ double FeatureExtractor::getArcScoreAtomic(FeatureExtractor* fe, DependencyInsta
 		score += tmp_ptr->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createArcFeatureVector(inst, h, m, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createArcFeatureVector(inst, h, m, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -579,6 +598,7 @@ double FeatureExtractor::getArcScoreAtomic(FeatureExtractor* fe, DependencyInsta
 void FeatureExtractor::getSibsFvUnsafe(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& ch1, HeadIndex& ch2, bool isSt,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread == 1);
+	assert(!fv || !fe->scoreOnly);
 	if (cache) {
 		int ch1Idx = inst->wordToSeg(ch1);
 		int ch2Idx = inst->wordToSeg(ch2);
@@ -586,9 +606,9 @@ void FeatureExtractor::getSibsFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 		int pos = (ch1Idx * cache->numSeg + ch2Idx) * 2 + isSt;
 		assert(pos < (int)cache->sibs.size());
 		if (!cache->sibs[pos]) {
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, tmpFv);
+			item_ptr tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			cache->sibs[pos] = tmp_ptr;
 		}
 		if (fv)
@@ -603,6 +623,7 @@ void FeatureExtractor::getSibsFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 void FeatureExtractor::getSibsFvAtomic(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& ch1, HeadIndex& ch2, bool isSt,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread != 1);
+	assert(!fv || !fe->scoreOnly);
 	if (cache) {
 		int ch1Idx = inst->wordToSeg(ch1);
 		int ch2Idx = inst->wordToSeg(ch2);
@@ -611,9 +632,9 @@ void FeatureExtractor::getSibsFvAtomic(FeatureExtractor* fe, DependencyInstance*
 		assert(pos < (int)cache->sibs.size());
 		item_ptr tmp_ptr = atomic_load(&cache->sibs[pos]);
 		if (!tmp_ptr) {
-			tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, tmpFv);
+			tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			atomic_store(&cache->sibs[pos], tmp_ptr);
 		}
 		if (fv) {
@@ -642,9 +663,9 @@ double FeatureExtractor::getSibsScoreUnsafe(FeatureExtractor* fe, DependencyInst
 		score += cache->sibs[pos]->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -666,9 +687,9 @@ double FeatureExtractor::getSibsScoreAtomic(FeatureExtractor* fe, DependencyInst
 		score += tmp_ptr->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createSibsFeatureVector(inst, ch1, ch2, isSt, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -678,6 +699,7 @@ double FeatureExtractor::getSibsScoreAtomic(FeatureExtractor* fe, DependencyInst
 void FeatureExtractor::getTripsFvUnsafe(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& par, HeadIndex& ch1, HeadIndex& ch2,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread == 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int parIdx = inst->wordToSeg(par);
@@ -692,9 +714,9 @@ void FeatureExtractor::getTripsFvUnsafe(FeatureExtractor* fe, DependencyInstance
 		int pos = id * cache->numSeg + ch1Idx;
 		assert(pos < (int)cache->trips.size());
 		if (!cache->trips[pos]) {
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, tmpFv);
+			item_ptr tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			cache->trips[pos] = tmp_ptr;
 		}
 		if (fv)
@@ -709,6 +731,7 @@ void FeatureExtractor::getTripsFvUnsafe(FeatureExtractor* fe, DependencyInstance
 void FeatureExtractor::getTripsFvAtomic(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& par, HeadIndex& ch1, HeadIndex& ch2,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread != 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int parIdx = inst->wordToSeg(par);
@@ -724,9 +747,9 @@ void FeatureExtractor::getTripsFvAtomic(FeatureExtractor* fe, DependencyInstance
 		assert(pos < (int)cache->trips.size());
 		item_ptr tmp_ptr = atomic_load(&cache->trips[pos]);
 		if (!tmp_ptr) {
-			tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, tmpFv);
+			tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			atomic_store(&cache->trips[pos], tmp_ptr);
 		}
 		if (fv) {
@@ -762,9 +785,9 @@ double FeatureExtractor::getTripsScoreUnsafe(FeatureExtractor* fe, DependencyIns
 		score += cache->trips[pos]->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -794,9 +817,9 @@ double FeatureExtractor::getTripsScoreAtomic(FeatureExtractor* fe, DependencyIns
 		score += tmp_ptr->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createTripsFeatureVector(inst, par, ch1, ch2, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -806,6 +829,7 @@ double FeatureExtractor::getTripsScoreAtomic(FeatureExtractor* fe, DependencyIns
 void FeatureExtractor::getGPCFvUnsafe(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& gp, HeadIndex& par, HeadIndex& c,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread == 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int gpIdx = inst->wordToSeg(gp);
@@ -820,9 +844,9 @@ void FeatureExtractor::getGPCFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 		int pos = id * cache->numSeg + cIdx;
 		assert(pos < (int)cache->gpc.size());
 		if (!cache->gpc[pos]) {
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createGPCFeatureVector(inst, gp, par, c, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createGPCFeatureVector(inst, gp, par, c, tmpFv);
+			item_ptr tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			cache->gpc[pos] = tmp_ptr;
 		}
 		if (fv)
@@ -837,6 +861,7 @@ void FeatureExtractor::getGPCFvUnsafe(FeatureExtractor* fe, DependencyInstance*
 void FeatureExtractor::getGPCFvAtomic(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& gp, HeadIndex& par, HeadIndex& c,
 		FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread != 1);
+	assert(!fv || !fe->scoreOnly);
 	int id = -1;
 	if (cache) {
 		int gpIdx = inst->wordToSeg(gp);
@@ -852,9 +877,9 @@ void FeatureExtractor::getGPCFvAtomic(FeatureExtractor* fe, DependencyInstance*
 		assert(pos < (int)cache->gpc.size());
 		item_ptr tmp_ptr = atomic_load(&cache->gpc[pos]);
 		if (!tmp_ptr) {
-			tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createGPCFeatureVector(inst, gp, par, c, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createGPCFeatureVector(inst, gp, par, c, tmpFv);
+			tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			atomic_store(&cache->gpc[pos], tmp_ptr);
 		}
 		if (fv) {
@@ -890,9 +915,9 @@ double FeatureExtractor::getGPCScoreUnsafe(FeatureExtractor* fe, DependencyInsta
 		score += cache->gpc[pos]->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createGPCFeatureVector(inst, gp, par, c, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createGPCFeatureVector(inst, gp, par, c, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -921,9 +946,9 @@ double FeatureExtractor::getGPCScoreAtomic(FeatureExtractor* fe, DependencyInsta
 		score += tmp_ptr->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createGPCFeatureVector(inst, gp, par, c, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createGPCFeatureVector(inst, gp, par, c, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -932,12 +957,13 @@ double FeatureExtractor::getGPCScoreAtomic(FeatureExtractor* fe, DependencyInsta
 
 void FeatureExtractor::getPosHOFvUnsafe(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& m, FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread == 1);
+	assert(!fv || !fe->scoreOnly);
 	if (cache) {
 		int pos = inst->wordToSeg(m);
 		if (!cache->posho[pos]) {
-			item_ptr tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createPosHOFeatureVector(inst, m, false, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createPosHOFeatureVector(inst, m, false, tmpFv);
+			item_ptr tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			cache->posho[pos] = tmp_ptr;
 		}
 		if (fv)
@@ -951,13 +977,14 @@ void FeatureExtractor::getPosHOFvUnsafe(FeatureExtractor* fe, DependencyInstance
 
 void FeatureExtractor::getPosHOFvAtomic(FeatureExtractor* fe, DependencyInstance* inst, HeadIndex& m, FeatureVector* fv, CacheTable* cache) {
 	assert(fe->thread != 1);
+	assert(!fv || !fe->scoreOnly);
 	if (cache) {
 		int pos = inst->wordToSeg(m);
 		item_ptr tmp_ptr = atomic_load(&cache->posho[pos]);
 		if (!tmp_ptr) {
-			tmp_ptr = item_ptr(new CacheItem());
-			fe->pipe->createPosHOFeatureVector(inst, m, false, &tmp_ptr->fv);
-			tmp_ptr->score = fe->parameters->getScore(&tmp_ptr->fv);
+			FeatureVector* tmpFv = fe->scratchVector();
+			fe->pipe->createPosHOFeatureVector(inst, m, false, tmpFv);
+			tmp_ptr = fe->newCacheItem(tmpFv, cache->arena.get());
 			atomic_store(&cache->posho[pos], tmp_ptr);
 		}
 		if (fv) {
@@ -982,9 +1009,9 @@ double FeatureExtractor::getPosHOScoreUnsafe(FeatureExtractor* fe, DependencyIns
 		score = cache->posho[pos]->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createPosHOFeatureVector(inst, m, false, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createPosHOFeatureVector(inst, m, false, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -1002,9 +1029,9 @@ double FeatureExtractor::getPosHOScoreAtomic(FeatureExtractor* fe, DependencyIns
 		score = tmp_ptr->score;
 	}
 	else {
-		FeatureVector fv;
-		fe->pipe->createPosHOFeatureVector(inst, m, false, &fv);
-		score = fe->parameters->getScore(&fv);
+		FeatureVector* fv = fe->scratchVector();
+		fe->pipe->createPosHOFeatureVector(inst, m, false, fv);
+		score = fe->parameters->getScore(fv);
 	}
 	return score;
 }
@@ -1012,6 +1039,7 @@ double FeatureExtractor::getPosHOScoreAtomic(FeatureExtractor* fe, DependencyIns
 //-------------------------------------------
 
 void FeatureExtractor::getSegFv(DependencyInstance* inst, int wordid, FeatureVector* fv) {
+	assert(!fv || !scoreOnly);
 	int pos = getSeg1OCachePos(wordid, inst->word[wordid].currSegCandID);
 	assert(pos < (int)seg1o.size() && seg1o[pos]);
 	if (fv) {
@@ -1028,6 +1056,7 @@ double FeatureExtractor::getSegScore(DependencyInstance* inst, int wordid) {
 //-------------------------------------------
 
 void FeatureExtractor::getPos1OFv(DependencyInstance* inst, HeadIndex& m, FeatureVector* fv) {
+	assert(!fv || !scoreOnly);
 	int pos = getPos1OCachePos(m.hWord, inst->word[m.hWord].currSegCandID, m.hSeg, inst->getElement(m).currPosCandID);
 	assert(pos1o[pos]);
 	if (fv) {
@@ -1112,9 +1141,9 @@ double FeatureExtractor::getPartialDepScore(DependencyInstance* s, HeadIndex& x,
 	}
 
 	if (options->useHO) {
-		FeatureVector fv;
-		pipe->createPartialHighOrderFeatureVector(s, x, false, &fv);
-		score += parameters->getScore(&fv);
+		FeatureVector* fv = scratchVector();
+		pipe->createPartialHighOrderFeatureVector(s, x, false, fv);
+		score += parameters->getScore(fv);
 	}
 
 	return score;
@@ -1192,9 +1221,9 @@ double FeatureExtractor::getPartialBigramDepScore(DependencyInstance* s, HeadInd
 	}
 
 	if (options->useHO) {
-		FeatureVector fv;
-		pipe->createPartialHighOrderFeatureVector(s, x, true, &fv);
-		score += parameters->getScore(&fv);
+		FeatureVector* fv = scratchVector();
+		pipe->createPartialHighOrderFeatureVector(s, x, true, fv);
+		score += parameters->getScore(fv);
 	}
 
 	return score;
@@ -1288,9 +1317,9 @@ double FeatureExtractor::getPartialPosScore(DependencyInstance* s, HeadIndex& x,
 	assert(mid == s->getNumSeg());
 
 	if (options->useHO) {
-		FeatureVector fv;
-		pipe->createPartialPosHighOrderFeatureVector(s, x, &fv);
-		score += parameters->getScore(&fv);
+		FeatureVector* fv = scratchVector();
+		pipe->createPartialPosHighOrderFeatureVector(s, x, fv);
+		score += parameters->getScore(fv);
 	}
 
 	return score;
@@ -1357,9 +1386,9 @@ double FeatureExtractor::getScore(DependencyInstance* s, CacheTable* cache) {
 	}
 
 	if (options->useHO) {
-		FeatureVector fv;
-		pipe->createHighOrderFeatureVector(s, &fv);
-		score += parameters->getScore(&fv);
+		FeatureVector* fv = scratchVector();
+		pipe->createHighOrderFeatureVector(s, fv);
+		score += parameters->getScore(fv);
 	}
 
 	return score;
@@ -28,7 +28,7 @@ class Parameters;
 
 class CacheItem {
 public:
-	FeatureVector fv;
+	PackedFeatureVector fv;		// in the arena of the table
 	double score;
 	int flag;
 
@@ -63,6 +63,10 @@ public:
 
 	int nuparcs;						// number of un-pruned arcs, include gold
 
+	// the items and their features, released with the last copy of the
+	// table. declared before the items, so that it is destroyed after them
+	boost::shared_ptr<Arena> arena;
+
 	vector<item_ptr> arc;		// first order cache [h][m]
 	vector<item_ptr> trips;		// second order [dep id][sib]
 	vector<item_ptr> sibs;		// [mod][sib][2]
@@ -77,7 +81,7 @@ private:
 class FeatureExtractor {
 public:
 	FeatureExtractor();
-	FeatureExtractor(DependencyInstance* inst, SegParser* parser, Parameters* params, int thread);
+	FeatureExtractor(DependencyInstance* inst, SegParser* parser, Parameters* params, int thread, bool scoreOnly);
 	virtual ~FeatureExtractor();
 
 	CacheTable* getCacheTable(DependencyInstance* s);
@@ -92,9 +96,16 @@ public:
 
 	vector<bool> isPruned(DependencyInstance* s, HeadIndex& m, CacheTable* cache);
 
+	// vectors are built in a per-thread scratch vector and scored once by
+	// Parameters::getScore. cache items copy the features to the arena with
+	// their score, a score-only extractor keeps just the score
+	FeatureVector* scratchVector();
+	item_ptr newCacheItem(FeatureVector* fv, Arena* arena);
+
 	int numWord;
 	int type;
 	int thread;
+	bool scoreOnly;			// decoding only, the get*Fv functions must not be used
 
 	//DependencyInstance* inst;		so risky to add this variable in multi-thread scenario. Other variables are read-only
 	DependencyPipe* pipe;
@@ -123,6 +134,8 @@ public:
 	void getSegFv(DependencyInstance* inst, int wordid, FeatureVector* fv);
 	double getSegScore(DependencyInstance* inst, int worid);
 
+	boost::shared_ptr<Arena> arena;			// for seg1o and pos1o, declared before them
+
 	vector<CacheTable> optSegCacheMap;		// cache for optimal seg for every word with different POS
 	vector<CacheTable> subOptSegCacheMap;	// cache for sub-optimal seg for one word with optimal POS
 
@@ -27,6 +27,10 @@ Options::Options() {
 
 	train = false;
 	test = false;
+	compile = false;
+	serve = false;
+	benchScore = false;
+	socketPath = "";
 
 	trainPruner = true;
 
@@ -44,6 +48,7 @@ Options::Options() {
 
 	devThread = 5;
 	trainThread = 10;
+	readThread = 4;
 
 	seed = 0;
 	regC = 0.0001;
@@ -64,6 +69,17 @@ Options::Options() {
 
 	saveBestModel = true;
 	bestScore = -100;
+
+	useMmap = true;
+	streamTrain = false;
+	featureCutoff = 1;
+	compactThresh = -1.0;
+	hashBits = 0;
+	quantize = QuantMode::None;
+	quantReport = false;
+	useSimd = true;
+	checkpointIters = 0;
+	resume = false;
 }
 
 Options::~Options() {
@@ -80,6 +96,18 @@ void Options::processArguments(int argc, char** argv) {
 		if(pair[0].compare("test") == 0) {
 			test = true;
 		}
+		if(pair[0].compare("compile") == 0) {
+			compile = true;
+		}
+		if(pair[0].compare("serve") == 0) {
+			serve = true;
+		}
+		if(pair[0].compare("benchscore") == 0) {
+			benchScore = true;
+		}
+		if(pair[0].compare("socket") == 0) {
+			socketPath = pair[1];
+		}
 		if(pair[0].compare("iters") == 0) {
 			numIters = atoi(pair[1].c_str());
 		}
@@ -106,6 +134,9 @@ void Options::processArguments(int argc, char** argv) {
 		if (pair[0].compare("trainthread") == 0) {
 			trainThread = atoi(pair[1].c_str());
 		}
+		if (pair[0].compare("readthread") == 0) {
+			readThread = atoi(pair[1].c_str());
+		}
 		if (pair[0].compare("max-sent") == 0) {
 			trainSentences = atoi(pair[1].c_str());
 		}
@@ -139,10 +170,52 @@ void Options::processArguments(int argc, char** argv) {
 		if (pair[0].compare("ho") == 0) {
 			useHO = (pair[1] == "true" ? true : false);
 		}
+		if (pair[0].compare("mmap") == 0) {
+			useMmap = (pair[1] == "true" ? true : false);
+		}
+		if (pair[0].compare("stream") == 0) {
+			streamTrain = (pair[1] == "true" ? true : false);
+		}
+		if (pair[0].compare("cutoff") == 0) {
+			featureCutoff = atoi(pair[1].c_str());
+		}
+		if (pair[0].compare("compact") == 0) {
+			compactThresh = atof(pair[1].c_str());
+		}
+		if (pair[0].compare("hashbits") == 0) {
+			hashBits = atoi(pair[1].c_str());
+		}
+		if (pair[0].compare("quantize") == 0) {
+			if (pair[1] == "float")
+				quantize = QuantMode::Float;
+			else if (pair[1] == "int16")
+				quantize = QuantMode::Int16;
+			else
+				quantize = QuantMode::None;
+		}
+		if (pair[0].compare("quantreport") == 0) {
+			quantReport = (pair[1] == "true" ? true : false);
+		}
+		if (pair[0].compare("simd") == 0) {
+			useSimd = (pair[1] == "true" ? true : false);
+		}
+		if (pair[0].compare("checkpoint") == 0) {
+			checkpointIters = atoi(pair[1].c_str());
+		}
+		if (pair[0].compare("resume") == 0) {
+			resume = (pair[1] == "true" ? true : false);
+		}
 
 		//TODO: add useHO option
 	}
 
+	// the hash kernel builds no alphabet: features are not counted, and a
+	// hashed model has a weight for every hash value
+	if (hashBits > 0 && featureCutoff > 1)
+		ThrowException("cutoff cannot be used with hashbits");
+	if (hashBits > 0 && compactThresh >= 0.0)
+		ThrowException("compact cannot be used with hashbits");
+
 
 	string file = trainFile;
 	if (file.empty())
@@ -195,6 +268,10 @@ void Options::outputArg() {
 	cout << "model-name: " << modelName << endl;
 	cout << "train: " << train << endl;
 	cout << "test: " << test << endl;
+	cout << "compile: " << compile << endl;
+	cout << "serve: " << serve << endl;
+	cout << "bench score: " << benchScore << endl;
+	cout << "socket: " << socketPath << endl;
 	cout << "training-iterations: " << numIters << endl;
 	cout << "seed: " << seed << endl;
 	cout << "use consecutive sibling: " << useCS << endl;
@@ -204,6 +281,7 @@ void Options::outputArg() {
 	cout << "testing mode: " << testingMode << endl;
 	cout << "train thread: " << trainThread << endl;
 	cout << "dev thread: " << devThread << endl;
+	cout << "read thread: " << readThread << endl;
 	cout << "reg C: " << regC << endl;
 	cout << "train converge iter: " << trainConvergeIter << endl;
 	cout << "test converge iter: " << testConvergeIter << endl;
@@ -212,6 +290,16 @@ void Options::outputArg() {
 	cout << "joint seg pos: " << jointSegPos << endl;
 	cout << "prune: " << trainPruner << endl;
 	cout << "save best model: " << saveBestModel << endl;
+	cout << "mmap reader: " << useMmap << endl;
+	cout << "stream training: " << streamTrain << endl;
+	cout << "feature cutoff: " << featureCutoff << endl;
+	cout << "compact threshold: " << compactThresh << endl;
+	cout << "hash kernel bits: " << hashBits << endl;
+	cout << "quantize: " << quantize << endl;
+	cout << "quantize report: " << quantReport << endl;
+	cout << "simd scoring: " << useSimd << endl;
+	cout << "checkpoint iters: " << checkpointIters << endl;
+	cout << "resume: " << resume << endl;
 	cout << "------\n" << endl;
 }
 
@@ -29,6 +29,10 @@ public:
 	// model type
 	bool train;
 	bool test;
+	bool compile;		// compile the input files into binary corpora and exit
+	bool serve;			// keep the model loaded and parse sentences from stdin or a socket
+	bool benchScore;	// time the score kernels on the arcs of the test file and exit
+	string socketPath;	// unix socket for the serve mode, stdin/stdout if empty
 
 	bool trainPruner;
 
@@ -46,6 +50,7 @@ public:
 
 	int devThread;
 	int trainThread;		// only useful when hill climbing training
+	int readThread;			// threads parsing the input files
 
 	int seed;
 	double regC;
@@ -67,6 +72,17 @@ public:
 	bool saveBestModel;
 	double bestScore;
 
+	bool useMmap;		// memory map the input files when reading instances
+	bool streamTrain;	// re-read the training file every iteration instead of keeping it in memory
+	int featureCutoff;	// drop features seen less often in the gold trees
+	double compactThresh;	// drop features with at most this absolute weight when saving, negative to keep all
+	int hashBits;		// hash features into 2^hashBits weights instead of building an alphabet, 0 to disable
+	int quantize;		// weights used for testing, QuantMode
+	bool quantReport;	// also test with the double weights and report the difference
+	bool useSimd;		// score with AVX2/AVX-512 gathers if the cpu has them
+	int checkpointIters;	// save the training state every n iterations, 0 to disable
+	bool resume;		// continue training from the checkpoint if there is one
+
 	Options();
 	virtual ~Options();
 
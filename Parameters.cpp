@@ -8,15 +8,21 @@
 #include "Parameters.h"
 #include <boost/multi_array.hpp>
 #include "util/SerializationUtils.h"
+#include "util/Constant.h"
+#include "util/ScoreKernel.h"
+#include <math.h>
+#include <sched.h>
 
 namespace segparser {
 
-Parameters::Parameters(int size, Options* options)
-	: size(size), options(options){
+Parameters::Parameters(int size, Options* options, bool learning)
+	: size(size), learning(learning), mappedParams(NULL), quantMode(QuantMode::None), options(options),
+	  snapshot(NULL), snapshotUpd(0.0), snapshotActive(false) {
 	parameters.clear();
 	total.clear();
 	parameters.resize(size, 0.0);
-	total.resize(size, 0.0);
+	if (learning)
+		total.resize(size, 0.0);
 }
 
 Parameters::~Parameters() {
@@ -26,13 +32,83 @@ void Parameters::copyParams(Parameters* param) {
 	parameters = param->parameters;
 	total = param->total;
 	size = param->size;
+	mappedParams = param->mappedParams;
 	options = param->options;
+
+	// the quantized weights are built again from the new weights
+	quantMode = QuantMode::None;
+	floatParams.clear();
+	shortParams.clear();
+	blockScale.clear();
 }
 
 void Parameters::averageParams(double avVal) {
+	// a dev run may still be reading the weights for its snapshot
+	finishSnapshot();
+
 	std::cout << "update time: " << avVal << std::endl;
 	for (int j = 0; j < size; ++j)
 		parameters[j] -= (avVal == 0 ? 0 : total[j] / avVal);
+
+	// learning is over, the sums are not needed any more
+	vector<double>().swap(total);
+}
+
+void Parameters::startSnapshot(Parameters* dest, double avVal) {
+	// called by the learner when no dev run is active
+	std::cout << "update time: " << avVal << std::endl;
+	dest->size = size;
+	dest->options = options;
+	dest->mappedParams = NULL;
+	dest->total.clear();
+	dest->parameters.resize(size);
+	dest->quantMode = QuantMode::None;
+	dest->floatParams.clear();
+	dest->shortParams.clear();
+	dest->blockScale.clear();
+
+	snapshot = dest;
+	snapshotUpd = avVal;
+	blockState.assign(((size - 1) >> SNAPSHOT_BLOCK_BITS) + 1, SnapshotState::Pending);
+	__atomic_store_n(&snapshotActive, true, __ATOMIC_RELEASE);
+}
+
+void Parameters::finishSnapshot() {
+	// called by the dev thread before it uses the snapshot
+	if (!__atomic_load_n(&snapshotActive, __ATOMIC_ACQUIRE))
+		return;
+
+	for (unsigned int b = 0; b < blockState.size(); ++b)
+		snapshotBlock(b);
+
+	__atomic_store_n(&snapshotActive, false, __ATOMIC_RELEASE);
+}
+
+void Parameters::snapshotIndex(int index) {
+	// called by the learner before it changes a weight
+	if (__atomic_load_n(&snapshotActive, __ATOMIC_ACQUIRE))
+		snapshotBlock(index >> SNAPSHOT_BLOCK_BITS);
+}
+
+void Parameters::snapshotBlock(int block) {
+	char* state = &blockState[block];
+	if (__atomic_load_n(state, __ATOMIC_ACQUIRE) == SnapshotState::Done)
+		return;
+
+	char expected = SnapshotState::Pending;
+	if (__atomic_compare_exchange_n(state, &expected, (char)SnapshotState::Busy,
+			false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+		int start = block << SNAPSHOT_BLOCK_BITS;
+		int end = min(size, start + (1 << SNAPSHOT_BLOCK_BITS));
+		for (int j = start; j < end; ++j)
+			snapshot->parameters[j] = parameters[j] - (snapshotUpd == 0 ? 0 : total[j] / snapshotUpd);
+		__atomic_store_n(state, (char)SnapshotState::Done, __ATOMIC_RELEASE);
+	}
+	else {
+		// the other thread is averaging this block
+		while (__atomic_load_n(state, __ATOMIC_ACQUIRE) != SnapshotState::Done)
+			sched_yield();
+	}
 }
 
 double Parameters::numError(DependencyInstance* gold, DependencyInstance* pred) {
@@ -162,7 +238,14 @@ void Parameters::update(DependencyInstance* target, DependencyInstance* curr,
 	if (loss < 1e-4)
 		return;
 
-	double l2norm = diffFv->dotProduct(diffFv);
+	// the difference of two trees mostly consists of entries that cancel
+	// out or repeat, so it is merged before it is used
+	vector<pair<int, double> > coef;
+	diffFv->mergeEntries(coef);
+
+	double l2norm = 0.0;
+	for (unsigned int i = 0; i < coef.size(); ++i)
+		l2norm += coef[i].second * coef[i].second;
 	if (l2norm <= 1e-6)
 		return;
 
@@ -172,37 +255,120 @@ void Parameters::update(DependencyInstance* target, DependencyInstance* curr,
 		alpha = options->regC;
 
 	if (alpha > 0) {
-		// update theta
-		for (unsigned int i = 0; i < diffFv->binaryIndex.size(); ++i) {
-			parameters[diffFv->binaryIndex[i]] += alpha;
-			total[diffFv->binaryIndex[i]] += upd * alpha;
-		}
-		for (unsigned int i = 0; i < diffFv->negBinaryIndex.size(); ++i) {
-			parameters[diffFv->negBinaryIndex[i]] -= alpha;
-			total[diffFv->negBinaryIndex[i]] -= upd * alpha;
+		if (__atomic_load_n(&snapshotActive, __ATOMIC_ACQUIRE)) {
+			// keep the dev snapshot at the weights before this update
+			for (unsigned int i = 0; i < coef.size(); ++i)
+				snapshotIndex(coef[i].first);
 		}
-		for (unsigned int i = 0; i < diffFv->normalIndex.size(); ++i) {
-			double val = min(2.0, max(-2.0, diffFv->normalValue[i]));
-			parameters[diffFv->normalIndex[i]] += alpha * val;
-			total[diffFv->normalIndex[i]] += upd * alpha * val;
+
+		// update theta
+		double updAlpha = upd * alpha;
+		for (unsigned int i = 0; i < coef.size(); ++i) {
+			parameters[coef[i].first] += alpha * coef[i].second;
+			total[coef[i].first] += updAlpha * coef[i].second;
 		}
 	}
 }
 
 double Parameters::getScore(FeatureVector* fv) {
+	if (quantMode == QuantMode::Float)
+		return getFloatScore(fv);
+	else if (quantMode == QuantMode::Int16)
+		return getShortScore(fv);
+
+	const double* w = mappedParams ? mappedParams : parameters.data();
+	if (learning) {
+		// the scores steer the updates, so training, and a run resumed from
+		// a checkpoint, must give the same weights on every cpu
+		double score = scalarGatherAdd(0.0, w, fv->binaryIndex.data(), fv->binaryIndex.size());
+		score = scalarGatherSub(score, w, fv->negBinaryIndex.data(), fv->negBinaryIndex.size());
+		score = scalarGatherDot(score, w, fv->normalIndex.data(), fv->normalValue.data(), fv->normalIndex.size());
+		return score;
+	}
+
+	double score = gatherAdd(0.0, w, fv->binaryIndex.data(), fv->binaryIndex.size());
+	score = gatherSub(score, w, fv->negBinaryIndex.data(), fv->negBinaryIndex.size());
+	score = gatherDot(score, w, fv->normalIndex.data(), fv->normalValue.data(), fv->normalIndex.size());
+	return score;
+}
+
+double Parameters::getFloatScore(FeatureVector* fv) {
+	const float* w = floatParams.data();
 	double score = 0.0;
 	for (unsigned int i = 0; i < fv->binaryIndex.size(); ++i) {
-		score += parameters[fv->binaryIndex[i]];
+		score += w[fv->binaryIndex[i]];
 	}
 	for (unsigned int i = 0; i < fv->negBinaryIndex.size(); ++i) {
-		score -= parameters[fv->negBinaryIndex[i]];
+		score -= w[fv->negBinaryIndex[i]];
 	}
 	for (unsigned int i = 0; i < fv->normalIndex.size(); ++i) {
-		score += parameters[fv->normalIndex[i]] * fv->normalValue[i];
+		score += w[fv->normalIndex[i]] * fv->normalValue[i];
 	}
 	return score;
 }
 
+double Parameters::getShortScore(FeatureVector* fv) {
+	const int16_t* w = shortParams.data();
+	const float* s = blockScale.data();
+	double score = 0.0;
+	for (unsigned int i = 0; i < fv->binaryIndex.size(); ++i) {
+		int id = fv->binaryIndex[i];
+		score += w[id] * s[id >> QUANT_BLOCK_BITS];
+	}
+	for (unsigned int i = 0; i < fv->negBinaryIndex.size(); ++i) {
+		int id = fv->negBinaryIndex[i];
+		score -= w[id] * s[id >> QUANT_BLOCK_BITS];
+	}
+	for (unsigned int i = 0; i < fv->normalIndex.size(); ++i) {
+		int id = fv->normalIndex[i];
+		score += w[id] * s[id >> QUANT_BLOCK_BITS] * fv->normalValue[i];
+	}
+	return score;
+}
+
+void Parameters::quantize(int mode) {
+	// only for inference, update() still works on the double weights
+	const double* w = mappedParams ? mappedParams : parameters.data();
+	double maxErr = 0.0;
+
+	if (mode == QuantMode::Float) {
+		floatParams.resize(size);
+		for (int i = 0; i < size; ++i) {
+			floatParams[i] = (float)w[i];
+			maxErr = max(maxErr, fabs(floatParams[i] - w[i]));
+		}
+	}
+	else if (mode == QuantMode::Int16) {
+		// the feature indices are not grouped by template, so the
+		// scale is shared by blocks of consecutive indices instead
+		int blockSize = 1 << QUANT_BLOCK_BITS;
+		int blockNum = (size + blockSize - 1) / blockSize;
+		shortParams.resize(size);
+		blockScale.resize(blockNum);
+		for (int b = 0; b < blockNum; ++b) {
+			int start = b * blockSize;
+			int end = min(size, start + blockSize);
+			double maxAbs = 0.0;
+			for (int i = start; i < end; ++i)
+				maxAbs = max(maxAbs, fabs(w[i]));
+			blockScale[b] = maxAbs > 0.0 ? maxAbs / 32767.0 : 1.0;
+			for (int i = start; i < end; ++i) {
+				shortParams[i] = (int16_t)lround(w[i] / blockScale[b]);
+				maxErr = max(maxErr, fabs(shortParams[i] * blockScale[b] - w[i]));
+			}
+		}
+	}
+	else if (mode != QuantMode::None) {
+		ThrowException("unknown quantization mode");
+	}
+
+	quantMode = mode;
+	if (mode != QuantMode::None) {
+		cout << "quantized " << size << " weights to " << (mode == QuantMode::Float ? "float" : "int16")
+				<< ", max weight error: " << maxErr << endl;
+	}
+}
+
 void Parameters::writeParams(FILE* fs) {
 	CHECK(WriteInteger(fs, size));
 	CHECK(WriteDoubleArray(fs, parameters));
@@ -9,6 +9,7 @@
 #define PARAMETERS_H_
 
 #include <vector>
+#include <stdint.h>
 #include "Options.h"
 #include "DependencyInstance.h"
 #include "util/FeatureVector.h"
@@ -23,17 +24,33 @@ class FeatureExtractor;
 class Parameters {
 public:
 	vector<double> parameters;
-	vector<double> total;
+	vector<double> total;		// sum of upd * change of each weight, only kept while learning
 	int size;
+	bool learning;				// scored with the scalar kernels, see getScore
 
-	Parameters(int size, Options* options);
+	const double* mappedParams;		// weights in a mapped model file, used instead of parameters
+
+	// inference-only copy of the weights, used by getScore when set
+	int quantMode;
+	vector<float> floatParams;
+	vector<int16_t> shortParams;
+	vector<float> blockScale;		// scale of each block of int16 weights
+
+	Parameters(int size, Options* options, bool learning);
 	virtual ~Parameters();
 
 	void copyParams(Parameters* param);
 	void averageParams(double avVal);
+
+	// averaged snapshot of the learned weights for development. the blocks
+	// are averaged by the dev thread, or by the learner before it changes them
+	void startSnapshot(Parameters* dest, double avVal);
+	void finishSnapshot();
+	void snapshotIndex(int index);
 	void update(DependencyInstance* gold, DependencyInstance* pred,
 			FeatureVector* diffFv, double loss, FeatureExtractor* fe, int upd);
 	double getScore(FeatureVector* fv);
+	void quantize(int mode);
 
 	void writeParams(FILE* fs);
 	void readParams(FILE* fs);
@@ -44,7 +61,16 @@ public:
 private:
 	Options* options;
 
+	Parameters* snapshot;
+	double snapshotUpd;
+	bool snapshotActive;
+	vector<char> blockState;		// SnapshotState of each block
+
+	void snapshotBlock(int block);
+
 	int maxMatch(SegInstance& gold, SegInstance& pred, vector<int>& match);
+	double getFloatScore(FeatureVector* fv);
+	double getShortScore(FeatureVector* fv);
 	double numError(DependencyInstance* gold, DependencyInstance* pred);
 };
 
@@ -7,19 +7,22 @@ CPP_SRCS += \
 ../decoder/ClassifierDecoder.cpp \
 ../decoder/DependencyDecoder.cpp \
 ../decoder/DevelopmentThread.cpp \
-../decoder/HillClimbingDecoder.cpp 
+../decoder/HillClimbingDecoder.cpp \
+../decoder/ParseServer.cpp 
 
 OBJS += \
 ./decoder/ClassifierDecoder.o \
 ./decoder/DependencyDecoder.o \
 ./decoder/DevelopmentThread.o \
-./decoder/HillClimbingDecoder.o 
+./decoder/HillClimbingDecoder.o \
+./decoder/ParseServer.o 
 
 CPP_DEPS += \
 ./decoder/ClassifierDecoder.d \
 ./decoder/DependencyDecoder.d \
 ./decoder/DevelopmentThread.d \
-./decoder/HillClimbingDecoder.d 
+./decoder/HillClimbingDecoder.d \
+./decoder/ParseServer.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -5,15 +5,21 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../io/DependencyReader.cpp \
-../io/DependencyWriter.cpp 
+../io/DependencyWriter.cpp \
+../io/ParallelReader.cpp \
+../io/TrainingCheckpoint.cpp 
 
 OBJS += \
 ./io/DependencyReader.o \
-./io/DependencyWriter.o 
+./io/DependencyWriter.o \
+./io/ParallelReader.o \
+./io/TrainingCheckpoint.o 
 
 CPP_DEPS += \
 ./io/DependencyReader.d \
-./io/DependencyWriter.d 
+./io/DependencyWriter.d \
+./io/ParallelReader.d \
+./io/TrainingCheckpoint.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
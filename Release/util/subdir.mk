@@ -5,30 +5,39 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../util/Alphabet.cpp \
+../util/Arena.cpp \
 ../util/Constant.cpp \
 ../util/FeatureAlphabet.cpp \
 ../util/FeatureVector.cpp \
 ../util/Logarithm.cpp \
+../util/ScoreKernel.cpp \
 ../util/SerializationUtils.cpp \
-../util/StringUtils.cpp 
+../util/StringUtils.cpp \
+../util/Symbol.cpp 
 
 OBJS += \
 ./util/Alphabet.o \
+./util/Arena.o \
 ./util/Constant.o \
 ./util/FeatureAlphabet.o \
 ./util/FeatureVector.o \
 ./util/Logarithm.o \
+./util/ScoreKernel.o \
 ./util/SerializationUtils.o \
-./util/StringUtils.o 
+./util/StringUtils.o \
+./util/Symbol.o 
 
 CPP_DEPS += \
 ./util/Alphabet.d \
+./util/Arena.d \
 ./util/Constant.d \
 ./util/FeatureAlphabet.d \
 ./util/FeatureVector.d \
 ./util/Logarithm.d \
+./util/ScoreKernel.d \
 ./util/SerializationUtils.d \
-./util/StringUtils.d 
+./util/StringUtils.d \
+./util/Symbol.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -9,18 +9,26 @@
 #include <pthread.h>
 #include "util/Random.h"
 #include <float.h>
+#include <math.h>
 #include "util/Timer.h"
 #include <fstream>
 #include "util/SerializationUtils.h"
+#include "util/Constant.h"
+#include "util/ScoreKernel.h"
 #include <set>
+#include "decoder/ParseServer.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace segparser {
 
 SegParser::SegParser(DependencyPipe* pipe, Options* options)
-	: pipe(pipe), options(options), devTimes(0) {
+	: pipe(pipe), options(options), devTimes(0), modelData(NULL), modelDataSize(0) {
 	// Set up arrays
-	parameters = new Parameters(pipe->dataAlphabet->size(), options);
-	devParams = new Parameters(pipe->dataAlphabet->size(), options);
+	parameters = new Parameters(pipe->dataAlphabet->size(), options, options->train);
+	devParams = new Parameters(pipe->dataAlphabet->size(), options, false);
 	pruner = NULL;
 	if (options->train) {
 		decoder = DependencyDecoder::createDependencyDecoder(options, options->learningMode, options->trainThread, true);
@@ -30,7 +38,6 @@ SegParser::SegParser(DependencyPipe* pipe, Options* options)
 		decoder = NULL;
 	}
 	dt = new DevelopmentThread();
-	FeatureVector::initVec(pipe->dataAlphabet->size());
 }
 
 void SegParser::closeDecoder() {
@@ -45,6 +52,9 @@ SegParser::~SegParser() {
 	delete dt;
 
 	delete pruner;
+
+	if (modelData)
+		munmap((void*)modelData, modelDataSize);
 }
 
 void SegParser::train(vector<inst_ptr>& il) {
@@ -60,7 +70,21 @@ void SegParser::train(vector<inst_ptr>& il) {
 		*(pred[i].get()) = *(il[i].get());
 	}
 
-	for(int i = 0; i < options->numIters; ++i) {
+	int startIter = 0;
+	if (options->resume) {
+		vector<VariableInfo> predInfo;
+		startIter = loadCheckpoint(predInfo);
+		if (startIter > 0 && predInfo.size() != il.size())
+			ThrowException("the checkpoint is for a different training set");
+		for (unsigned int i = 0; startIter > 0 && i < il.size(); ++i) {
+			predInfo[i].loadInfoToInst(pred[i].get());
+			pred[i]->constructConversionList();
+			pred[i]->setOptSegPosCount();
+			pred[i]->buildChild();
+		}
+	}
+
+	for(int i = startIter; i < options->numIters; ++i) {
 
 		cout << "========================" << endl;
 		cout << "Iteration: " << i << endl;
@@ -78,6 +102,7 @@ void SegParser::train(vector<inst_ptr>& il) {
 	}
 
 	parameters->averageParams(decoder->getUpdateTimes());
+	checkpoint.waitSaving();
 
 	// wait until dev finish
 	if (options->test) {
@@ -102,35 +127,159 @@ void SegParser::trainingIter(vector<inst_ptr>& goldList, vector<inst_ptr>& predL
 			cout.flush();
 		}
 
-		inst_ptr gold = goldList[i];
-		inst_ptr pred = predList[i];
+		trainInstance(goldList[i].get(), predList[i].get(), iter);
+	}
+
+	cout << endl;
+
+	cout << "  " << goldList.size() << " instances" << endl;
+
+	if (options->checkpointIters > 0 && iter % options->checkpointIters == 0) {
+		vector<VariableInfo> predInfo;
+		for (unsigned int i = 0; i < predList.size(); ++i)
+			predInfo.push_back(VariableInfo(predList[i].get()));
+		saveCheckpoint(iter, predInfo);
+	}
+
+	if (options->test)
+		checkDevStatus(iter);
+}
 
-		FeatureExtractor fe(pred.get(), this, parameters, options->trainThread);
+void SegParser::train(string trainFile) {
 
-		string str;
+	cout << "About to train (streaming)" << endl;
 
-		assert(gold->fv.binaryIndex.size() > 0);
+	devTimes = 0;
 
-		decoder->train(gold.get(), pred.get(), &fe, iter);
+	// only the decoded variables of the pred instances are kept between
+	// iterations, the instances themselves are read again from the file
+	vector<VariableInfo> predInfo;
 
-		if (options->useSP) {
-			uint64_t code = pipe->fe->genCodePF(HighOrder::SEG_PROB, 0);
-			int index = pipe->dataAlphabet->lookupIndex(TemplateType::THighOrder, code, false);
-			if (index > 0 && parameters->parameters[index] < 0.0) {
-				parameters->parameters[index] = 0.0;
-			}
+	int startIter = 0;
+	if (options->resume)
+		startIter = loadCheckpoint(predInfo);
+
+	for(int i = startIter; i < options->numIters; ++i) {
+
+		cout << "========================" << endl;
+		cout << "Iteration: " << i << endl;
+		cout << "========================" << endl;
+		cout << "Processed: ";
+		cout.flush();
+
+		Timer timer;
+
+		trainingIter(trainFile, predInfo, i+1);
+
+		double diff = timer.stop();
+		cout << "Training iter took: " << diff / 1000 << " secs." << endl;
+
+	}
+
+	parameters->averageParams(decoder->getUpdateTimes());
+	checkpoint.waitSaving();
+
+	// wait until dev finish
+	if (options->test) {
+		if (dt->isDevTesting)
+			pthread_join(dt->workThread, NULL);
+	}
+
+	if (options->saveBestModel) {
+		cout << "Best model performance: " << options->bestScore << endl;
+	}
+}
+
+void SegParser::trainingIter(string trainFile, vector<VariableInfo>& predInfo, int iter) {
+
+	Timer timer;
+
+	DependencyReader reader(options, trainFile);
+	if (!options->jointSegPos)
+		reader.hasCandidate = false;
+	reader.isTrain = true;
+
+	// same selection as DependencyPipe::createInstances
+	unsigned int i = 0;
+	inst_ptr gold = reader.nextInstance();
+	while (gold && (int)i < options->trainSentences) {
+		if (gold->getNumSeg() - 1 > options->maxLength) {
+			gold = reader.nextInstance();
+			continue;
+		}
+
+		if((i+1) % 100 == 0) {
+			cout << "  " << (i+1);
+			double diff = timer.stop();
+			cout << " (time=" << (int)(diff / 1000) << "s)";
+			cout.flush();
 		}
 
+		gold->setInstIds(pipe, options);
+		pipe->createFeatureVector(gold.get(), &(gold->fv));
+
+		inst_ptr pred(new DependencyInstance());
+		*(pred.get()) = *(gold.get());
+		if (i < predInfo.size()) {
+			// continue from the previous iteration
+			predInfo[i].loadInfoToInst(pred.get());
+			pred->constructConversionList();
+			pred->setOptSegPosCount();
+			pred->buildChild();
+		}
+
+		trainInstance(gold.get(), pred.get(), iter);
+
+		if (i < predInfo.size())
+			predInfo[i].copyInfoFromInst(pred.get());
+		else
+			predInfo.push_back(VariableInfo(pred.get()));
+
+		i++;
+		gold = reader.nextInstance();
 	}
+	reader.close();
 
 	cout << endl;
 
-	cout << "  " << goldList.size() << " instances" << endl;
+	cout << "  " << i << " instances" << endl;
+
+	if (options->checkpointIters > 0 && iter % options->checkpointIters == 0)
+		saveCheckpoint(iter, predInfo);
 
 	if (options->test)
 		checkDevStatus(iter);
 }
 
+void SegParser::trainInstance(DependencyInstance* gold, DependencyInstance* pred, int iter) {
+	FeatureExtractor fe(pred, this, parameters, options->trainThread, false);
+
+	assert(gold->fv.binaryIndex.size() > 0);
+
+	decoder->train(gold, pred, &fe, iter);
+
+	if (options->useSP) {
+		uint64_t code = pipe->fe->genCodePF(HighOrder::SEG_PROB, 0);
+		if (pipe->dataAlphabet->isHashed()) {
+			// the feature is subtracted for a negative hash index
+			int index = pipe->dataAlphabet->hashIndex(TemplateType::THighOrder, code);
+			double sign = index > 0 ? 1.0 : -1.0;
+			index = abs(index);
+			if (sign * parameters->parameters[index] < 0.0) {
+				parameters->snapshotIndex(index);
+				parameters->parameters[index] = 0.0;
+			}
+		}
+		else {
+			int index = pipe->dataAlphabet->lookupIndex(TemplateType::THighOrder, code, false);
+			if (index > 0 && parameters->parameters[index] < 0.0) {
+				parameters->snapshotIndex(index);
+				parameters->parameters[index] = 0.0;
+			}
+		}
+	}
+}
+
 void SegParser::checkDevStatus(int iter) {
 	if (dt->isDevTesting) {
 		cout << "processing sentences: ";
@@ -152,25 +301,72 @@ void SegParser::checkDevStatus(int iter) {
 	string devoutfile = options->outFile;
 
 	cout << "build dev params" << endl;
-	devParams->copyParams(parameters);
-	devParams->averageParams(decoder->getUpdateTimes());
+	parameters->startSnapshot(devParams, decoder->getUpdateTimes());
 
 	cout << "start new dev " << devTimes << endl;
 	dt->start(devfile, devoutfile, this, false);
 	devTimes++;
 }
 
+void SegParser::saveCheckpoint(int iter, vector<VariableInfo>& predInfo) {
+	// the state of the previous checkpoint is replaced below
+	checkpoint.waitSaving();
+
+	// the best score must include the dev run of the last iteration,
+	// checkDevStatus would wait for it anyway
+	if (dt->isDevTesting)
+		pthread_join(dt->workThread, NULL);
+
+	cout << "save checkpoint " << iter << endl;
+	checkpoint.iter = iter;
+	checkpoint.seed = options->seed;
+	checkpoint.dictKey = pipe->dictKey;
+	checkpoint.updateTimes = decoder->getUpdateTimes();
+	checkpoint.bestScore = options->bestScore;
+	checkpoint.parameters = parameters->parameters;
+	checkpoint.total = parameters->total;
+	checkpoint.predInfo = predInfo;
+	checkpoint.startSaving(options->modelName + ".ckpt");
+}
+
+int SegParser::loadCheckpoint(vector<VariableInfo>& predInfo) {
+	string file = options->modelName + ".ckpt";
+	if (!checkpoint.load(file)) {
+		cout << "No checkpoint " << file << ", training from the beginning" << endl;
+		return 0;
+	}
+
+	if (checkpoint.seed != options->seed || checkpoint.dictKey != pipe->dictKey
+			|| checkpoint.parameters.size() != parameters->parameters.size())
+		ThrowException("the checkpoint " + file + " is for a different training setup");
+
+	cout << "Resume from checkpoint " << file << " after iteration " << checkpoint.iter << endl;
+	parameters->parameters.swap(checkpoint.parameters);
+	parameters->total.swap(checkpoint.total);
+	decoder->setUpdateTimes(checkpoint.updateTimes);
+	options->bestScore = checkpoint.bestScore;
+	predInfo.swap(checkpoint.predInfo);
+
+	// the dev run of that iteration was not finished when it was saved
+	if (options->test && checkpoint.iter > 0) {
+		devTimes = checkpoint.iter - 1;
+		checkDevStatus(checkpoint.iter);
+	}
+
+	return checkpoint.iter;
+}
+
 ///////////////////////////////////////////////////////
 // Saving and loading models
 ///////////////////////////////////////////////////////
 void SegParser::outputWeight(ofstream& fout, int type, Parameters* params) {
-	unordered_map<uint64_t, int>* intmap = pipe->dataAlphabet->getMap(type);
-	for (auto kv : (*intmap)) {
-		uint64_t s = kv.first;
-		int index = kv.second;
-		if (index > 0) {
-			fout << s << "\t" << parameters->parameters[index] << "\t" << parameters->total[index] << endl;
-		}
+	vector<uint64_t> keys;
+	vector<int> index;
+	pipe->dataAlphabet->toArray(type, keys, index);
+	// a mapped model has no copy of the weights in params->parameters
+	const double* w = params->mappedParams ? params->mappedParams : params->parameters.data();
+	for (unsigned int i = 0; i < keys.size(); ++i) {
+		fout << keys[i] << "\t" << w[index[i]] << endl;
 	}
 }
 
@@ -183,31 +379,165 @@ void SegParser::outputWeight(string fStr) {
 	fout.close();
 }
 
+static void alignFile(FILE* fs) {
+	while (ftell(fs) % sizeof(uint64_t) != 0)
+		CHECK((fputc(0, fs) != EOF));
+}
+
 void SegParser::saveModel(string file, Parameters* params) {
-	FILE *fs = fopen(file.c_str(), "wb");
-	params->writeParams(fs);
-	pipe->dataAlphabet->writeObject(fs);
-	pipe->typeAlphabet->writeObject(fs);
-	pipe->posAlphabet->writeObject(fs);
-	pipe->lexAlphabet->writeObject(fs);
+	// other processes may have the old model mapped, so replace it
+	// instead of overwriting it in place
+	string tmpFile = file + ".tmp";
+	FILE *fs = fopen(tmpFile.c_str(), "wb");
+	if (!fs)
+		ThrowException("cannot open " + tmpFile);
+
+	FeatureAlphabet* alphabet = pipe->dataAlphabet;
+	const double* w = params->mappedParams ? params->mappedParams : params->parameters.data();
+	int size = params->size;
+
+	FeatureAlphabet compactAlphabet(0);
+	vector<double> compactParams;
+	if (options->compactThresh >= 0.0 && !alphabet->isHashed()) {
+		// a feature without weight scores the same as an unknown one
+		vector<int> newIndex(size, 0);
+		compactParams.push_back(0.0);
+		for (int i = 1; i < size; ++i) {
+			if (fabs(w[i]) > options->compactThresh) {
+				newIndex[i] = compactParams.size();
+				compactParams.push_back(w[i]);
+			}
+		}
+		compactAlphabet.renumber(alphabet, newIndex);
+		cout << "(kept " << compactParams.size() - 1 << " of " << size - 1 << " features) ";
+		alphabet = &compactAlphabet;
+		w = compactParams.data();
+		size = compactParams.size();
+	}
+
+	CHECK(WriteInteger(fs, MODEL_FILE_MAGIC));
+	CHECK(WriteInteger(fs, MODEL_FILE_VERSION));
+	CHECK(WriteInteger(fs, size));
+	long offsetPos = ftell(fs);
+	CHECK(WriteUINT64(fs, 0));		// offset of the weights, filled below
+
+	// the dictionaries are small and are read normally. they are only
+	// written by the pipe that owns them, i.e. not by the pruner
+	CHECK(WriteBool(fs, !pipe->sharedDictionaries));
+	if (!pipe->sharedDictionaries) {
+		pipe->typeAlphabet->writeObject(fs);
+		pipe->posAlphabet->writeObject(fs);
+		pipe->lexAlphabet->writeObject(fs);
+	}
+
+	// weights and feature tables are used in place
+	alignFile(fs);
+	uint64_t paramOffset = ftell(fs);
+	CHECK((fwrite(w, sizeof(double), size, fs) == (size_t)size));
+	alphabet->writeTable(fs);
+
+	fseek(fs, offsetPos, SEEK_SET);
+	CHECK(WriteUINT64(fs, paramOffset));
 	fclose(fs);
+
+	if (rename(tmpFile.c_str(), file.c_str()) != 0)
+		ThrowException("cannot write " + file);
 }
 
 void SegParser::loadModel(string file) {
 	FILE *fs = fopen(file.c_str(), "rb");
-	parameters->readParams(fs);
-	pipe->dataAlphabet->readObject(fs);
-	pipe->typeAlphabet->readObject(fs);
-	pipe->posAlphabet->readObject(fs);
-	pipe->lexAlphabet->readObject(fs);
+	if (!fs)
+		ThrowException("cannot open " + file);
+
+	int magic = 0;
+	if (ReadInteger(fs, &magic) && magic == MODEL_FILE_MAGIC) {
+		loadMappedModel(file, fs);
+	}
+	else {
+		// model saved before the mapped format
+		rewind(fs);
+		parameters->readParams(fs);
+		pipe->dataAlphabet->readObject(fs);
+		if (pipe->sharedDictionaries) {
+			// the same dictionaries are already loaded
+			Alphabet typeAlphabet, posAlphabet, lexAlphabet;
+			typeAlphabet.readObject(fs);
+			posAlphabet.readObject(fs);
+			lexAlphabet.readObject(fs);
+		}
+		else {
+			pipe->typeAlphabet->readObject(fs);
+			pipe->posAlphabet->readObject(fs);
+			pipe->lexAlphabet->readObject(fs);
+		}
+
+		parameters->total.clear();
+		parameters->size = parameters->parameters.size();
+	}
 	fclose(fs);
 
 	pipe->closeAlphabets();
 	pipe->setAndCheckOffset();
+}
+
+void SegParser::loadMappedModel(string file, FILE* fs) {
+	int version = 0;
+	CHECK(ReadInteger(fs, &version));
+	if (version != MODEL_FILE_VERSION && version != 2)
+		ThrowException("unsupported model version in " + file);
+
+	int size = 0;
+	uint64_t paramOffset = 0;
+	CHECK(ReadInteger(fs, &size));
+	CHECK(ReadUINT64(fs, &paramOffset));
+
+	bool hasDictionaries = true;		// always stored before version 3
+	if (version >= 3)
+		CHECK(ReadBool(fs, &hasDictionaries));
+
+	if (!pipe->sharedDictionaries) {
+		if (!hasDictionaries)
+			ThrowException("no dictionaries in " + file + ", load the main model first");
+		pipe->typeAlphabet->readObject(fs);
+		pipe->posAlphabet->readObject(fs);
+		pipe->lexAlphabet->readObject(fs);
+	}
 
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		ThrowException("cannot open " + file);
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		ThrowException("cannot stat " + file);
+	}
+
+	// shared, so that processes loading the same model share the pages
+	void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED)
+		ThrowException("cannot map " + file);
+
+	if (modelData)
+		munmap((void*)modelData, modelDataSize);
+	modelData = (const char*)addr;
+	modelDataSize = st.st_size;
+
+	// the weights and the tables must lie inside the mapping
+	const char* mapEnd = modelData + modelDataSize;
+	if (size <= 0 || paramOffset % sizeof(double) != 0 || paramOffset > modelDataSize
+			|| (uint64_t)size > (modelDataSize - paramOffset) / sizeof(double))
+		ThrowException("truncated model file " + file);
+	const char* tables = modelData + paramOffset + size * sizeof(double);
+	if (!pipe->dataAlphabet->mapTable(tables, mapEnd))
+		ThrowException("truncated or corrupted model file " + file);
+	if (pipe->dataAlphabet->size() > size)
+		ThrowException("corrupted model file " + file + ", more features than weights");
+
+	parameters->parameters.clear();
 	parameters->total.clear();
-	parameters->total.resize(parameters->parameters.size());
-	parameters->size = parameters->parameters.size();
+	parameters->size = size;
+	parameters->mappedParams = (const double*)(modelData + paramOffset);
 }
 
 void SegParser::evaluatePruning() {
@@ -272,12 +602,104 @@ void SegParser::evaluatePruning() {
 
 using namespace segparser;
 
+// number of sentences that differ between two output files
+int countDiffSentences(string file1, string file2, int& total) {
+	ifstream in1(file1.c_str());
+	ifstream in2(file2.c_str());
+
+	int diff = 0;
+	total = 0;
+	string s1, s2, line;
+	bool more = true;
+	while (more) {
+		s1.clear();
+		s2.clear();
+		while (getline(in1, line) && !line.empty())
+			s1 += line + "\n";
+		while (getline(in2, line) && !line.empty())
+			s2 += line + "\n";
+		more = !s1.empty() || !s2.empty();
+		if (more) {
+			total++;
+			if (s1 != s2)
+				diff++;
+		}
+	}
+	return diff;
+}
+
+static void benchmarkScoreKernels(SegParser* sp, Options* options) {
+	// all arcs between the gold segments of the test sentences, i.e. the
+	// vectors scored when the arc cache tables are filled
+	vector<FeatureVector> fvs;
+	long numFeats = 0;
+	DependencyReader reader(options, options->testFile);
+	if (!options->jointSegPos)
+		reader.hasCandidate = false;
+	inst_ptr inst = reader.nextInstance();
+	int num = 0;
+	while (inst && num < options->testSentences && fvs.size() < 200000) {
+		inst->setInstIds(sp->pipe, options);
+		vector<HeadIndex> segs(1, HeadIndex(0, 0));
+		for (int i = 1; i < inst->numWord; ++i)
+			for (int j = 0; j < inst->word[i].getCurrSeg().size(); ++j)
+				segs.push_back(HeadIndex(i, j));
+
+		for (unsigned int h = 0; h < segs.size(); ++h)
+			for (unsigned int m = 1; m < segs.size(); ++m) {
+				if (h == m)
+					continue;
+				fvs.push_back(FeatureVector());
+				sp->pipe->createArcFeatureVector(inst.get(), segs[h], segs[m], &fvs.back());
+				numFeats += fvs.back().binaryIndex.size() + fvs.back().negBinaryIndex.size() + fvs.back().normalIndex.size();
+			}
+
+		num++;
+		inst = reader.nextInstance();
+	}
+	reader.close();
+
+	if (fvs.empty())
+		ThrowException("no arcs in " + options->testFile);
+
+	cout << num << " sentences, " << fvs.size() << " arc vectors, "
+			<< (double)numFeats / fvs.size() << " features per vector" << endl;
+
+	int reps = max(1, 20000000 / (int)fvs.size());
+	double scalarTime = 0.0;
+	double scalarSum = 0.0;
+	for (int k = 0; k < ScoreKernel::Count; ++k) {
+		if (!setScoreKernel(k)) {
+			cout << ScoreKernel::kernelString[k] << ": not supported by this cpu" << endl;
+			continue;
+		}
+
+		Timer timer;
+		double sum = 0.0;
+		for (int r = 0; r < reps; ++r)
+			for (unsigned int i = 0; i < fvs.size(); ++i)
+				sum += sp->parameters->getScore(&fvs[i]);
+		double diff = max(1.0, timer.stop());
+
+		if (k == ScoreKernel::Scalar) {
+			scalarTime = diff;
+			scalarSum = sum;
+		}
+		cout << ScoreKernel::kernelString[k] << ": " << diff * 1e6 / ((double)reps * fvs.size()) << " ns per vector, speedup "
+				<< scalarTime / diff << ", score difference " << fabs(sum - scalarSum) / reps << endl;
+	}
+
+	selectScoreKernel(options->useSimd);
+}
+
 int main(int argc, char** argv) {
 	//test1();
 
 	Options options;
 	options.processArguments(argc, argv);
 
+	selectScoreKernel(options.useSimd);
+
 	Options prunerOptions = options;
 	prunerOptions.setPrunerOptions();
 
@@ -286,6 +708,73 @@ int main(int argc, char** argv) {
 
     DependencyPipe pipe(&options);
 
+	if (options.compile) {
+		// resolve the corpora against the dictionaries of the training
+		// file, or of an existing model
+		if (!options.trainFile.empty()) {
+			pipe.loadCoarseMap(options.trainFile);
+			pipe.buildDictionary(options.trainFile);
+		}
+		else {
+			pipe.loadCoarseMap(options.testFile);
+			SegParser sp(&pipe, &options);
+			sp.loadModel(options.modelName);
+		}
+
+		if (!options.trainFile.empty())
+			pipe.compileCorpus(options.trainFile, options.trainFile + ".bin", true);
+		if (!options.testFile.empty())
+			pipe.compileCorpus(options.testFile, options.testFile + ".bin", false);
+
+		return 0;
+	}
+
+	if (options.benchScore) {
+		pipe.loadCoarseMap(options.testFile);
+		SegParser sp(&pipe, &options);
+		sp.loadModel(options.modelName);
+		benchmarkScoreKernels(&sp, &options);
+
+		return 0;
+	}
+
+	if (options.serve) {
+		// log to stderr, stdout may carry the parses
+		cout.rdbuf(cerr.rdbuf());
+
+		DependencyPipe servePipe(&options);
+		servePipe.loadCoarseMap(options.testFile);
+
+		SegParser serveSp(&servePipe, &options);
+
+		cout << "Loading model ... ";
+		cout.flush();
+		serveSp.loadModel(options.modelName);
+		if (options.trainPruner) {
+			// the pruner uses the dictionaries of the main model
+			prunerPipe.loadCoarseMap(prunerOptions.testFile);
+			prunerPipe.shareDictionaries(&servePipe);
+
+			pruner = new SegParser(&prunerPipe, &prunerOptions);
+			pruner->pruner = NULL;
+			pruner->loadModel(options.modelName + ".pruner");
+		}
+		serveSp.pruner = pruner;
+		serveSp.devParams->copyParams(serveSp.parameters);
+		if (options.quantize != QuantMode::None) {
+			serveSp.devParams->quantize(options.quantize);
+			if (pruner)
+				pruner->parameters->quantize(options.quantize);
+		}
+		cout << "done." << endl;
+
+		ParseServer server(&serveSp);
+		server.serve();
+		serveSp.closeDecoder();
+
+		return 0;
+	}
+
 	if (options.train) {
 
 		if (options.trainPruner) {
@@ -295,7 +784,14 @@ int main(int argc, char** argv) {
 
 			prunerPipe.loadCoarseMap(prunerOptions.trainFile);
 
-			vector<inst_ptr> trainingData = prunerPipe.createInstances(prunerOptions.trainFile);
+			// the dictionaries are built once, and only saved with the main model
+			prunerPipe.shareDictionaries(&pipe);
+
+			vector<inst_ptr> trainingData;
+			if (prunerOptions.streamTrain)
+				prunerPipe.createAlphabet(prunerOptions.trainFile);
+			else
+				trainingData = prunerPipe.createInstances(prunerOptions.trainFile);
 
 			pruner = new SegParser(&prunerPipe, &prunerOptions);
 			pruner->pruner = NULL;
@@ -305,7 +801,10 @@ int main(int argc, char** argv) {
 			cout << "Pruner Num Feats: " << numFeats << endl;
 			cout << "Pruner Num Edge Labels: " << numTypes << endl;
 
-			pruner->train(trainingData);
+			if (prunerOptions.streamTrain)
+				pruner->train(prunerOptions.trainFile);
+			else
+				pruner->train(trainingData);
 			pruner->closeDecoder();
 
 			pruner->evaluatePruning();
@@ -316,7 +815,11 @@ int main(int argc, char** argv) {
 
 	    pipe.loadCoarseMap(options.trainFile);
 
-	    vector<inst_ptr> trainingData = pipe.createInstances(options.trainFile);
+	    vector<inst_ptr> trainingData;
+	    if (options.streamTrain)
+	    	pipe.createAlphabet(options.trainFile);
+	    else
+	    	trainingData = pipe.createInstances(options.trainFile);
 
 	    //pipe.closeAlphabets();
 
@@ -328,7 +831,10 @@ int main(int argc, char** argv) {
 	    cout << "Num Feats: " << numFeats << endl;
 	    cout << "Num Edge Labels: " << numTypes << endl;
 
-	    sp.train(trainingData);
+	    if (options.streamTrain)
+	    	sp.train(options.trainFile);
+	    else
+	    	sp.train(trainingData);
 	    sp.closeDecoder();
 	}
 
@@ -340,10 +846,13 @@ int main(int argc, char** argv) {
 
 	    cout << "\nLoading model ... ";
 	    cout.flush();
+	    testSp.loadModel(options.modelName);
+
 	    pruner = NULL;
 		if (options.trainPruner) {
-
+			// the pruner uses the dictionaries of the main model
 			prunerPipe.loadCoarseMap(prunerOptions.testFile);
+			prunerPipe.shareDictionaries(&testPipe);
 
 			pruner = new SegParser(&prunerPipe, &prunerOptions);
 			pruner->pruner = NULL;
@@ -355,7 +864,6 @@ int main(int argc, char** argv) {
 			cout << "Pruner Num Edge Labels: " << numTypes << endl;
 		}
 		testSp.pruner = pruner;
-	    testSp.loadModel(options.modelName);
 	    cout << "done." << endl;
 
 	    int numFeats = testPipe.dataAlphabet->size() - 1;
@@ -370,10 +878,33 @@ int main(int argc, char** argv) {
 		string devoutfile = options.outFile;
 		cout << "build dev params" << endl;
 		testSp.devParams->copyParams(testSp.parameters);
+
+		double doubleF1 = 0.0;
+		if (options.quantize != QuantMode::None) {
+			if (options.quantReport) {
+				// reference run for the drift report
+				cout << "test with double weights" << endl;
+				testSp.dt->start(devfile, devoutfile + ".double", &testSp, true);
+				pthread_join(testSp.dt->workThread, NULL);
+				doubleF1 = testSp.dt->depF1;
+			}
+
+			testSp.devParams->quantize(options.quantize);
+			if (pruner)
+				pruner->parameters->quantize(options.quantize);
+		}
+
 	    testSp.dt->start(devfile, devoutfile, &testSp, true);
 
 	    // wait until all finishes
 	    pthread_join(testSp.dt->workThread, NULL);
+
+	    if (options.quantize != QuantMode::None && options.quantReport) {
+	    	int total = 0;
+	    	int diff = countDiffSentences(devoutfile + ".double", devoutfile, total);
+	    	cout << "Quantization drift: dep f1 " << doubleF1 << " (double) vs " << testSp.dt->depF1
+	    			<< " (quantized), " << diff << " of " << total << " sentences changed" << endl;
+	    }
 	    testSp.closeDecoder();
 	}
 
@@ -16,6 +16,7 @@
 #include "Parameters.h"
 #include "Options.h"
 #include "decoder/DependencyDecoder.h"
+#include "io/TrainingCheckpoint.h"
 
 namespace segparser {
 
@@ -32,7 +33,12 @@ public:
 	virtual ~SegParser();
 	void train(vector<inst_ptr>& il);
 	void trainingIter(vector<inst_ptr>& goldList, vector<inst_ptr>& predList, int iter);
+	void train(string trainFile);
+	void trainingIter(string trainFile, vector<VariableInfo>& predInfo, int iter);
+	void trainInstance(DependencyInstance* gold, DependencyInstance* pred, int iter);
 	void checkDevStatus(int iter);
+	void saveCheckpoint(int iter, vector<VariableInfo>& predInfo);
+	int loadCheckpoint(vector<VariableInfo>& predInfo);
 
 	void outputWeight(ofstream& fout, int type, Parameters* params);
 	void outputWeight(string fStr);
@@ -53,6 +59,14 @@ public:
 
 private:
 	int devTimes;
+
+	TrainingCheckpoint checkpoint;		// the last one, may still be being written
+
+	// mapped model file, the weights and the feature tables point into it
+	const char* modelData;
+	size_t modelDataSize;
+
+	void loadMappedModel(string file, FILE* fs);
 };
 
 } /* namespace segparser */
@@ -97,9 +97,7 @@ void ClassifierDecoder::findOptHead(DependencyInstance* pred, DependencyInstance
 			HeadIndex h(hw, hs);
 
 			predSegEle.dep = h;
-			FeatureVector fv;
-			fe->getArcFv(fe, pred, h, m, &fv, cache);
-			double score = fe->parameters->getScore(&fv);
+			double score = fe->getArcScore(fe, pred, h, m, cache);
 			if (gold) {
 				// add loss
 				score += fe->parameters->wordDepError(gold->word[m.hWord], pred->word[m.hWord]);
@@ -230,16 +230,16 @@ double DependencyDecoder::samplePos1O(DependencyInstance* inst, DependencyInstan
 			ele.currPosCandID = j;
 
 			probList[j] = fe->getPos1OScore(inst, m);
-			FeatureVector tmpfv;
-			fe->pipe->createPosHOFeatureVector(inst, m, true, &tmpfv);
-			probList[j] += fe->parameters->getScore(&tmpfv);
+			FeatureVector* tmpfv = fe->scratchVector();
+			fe->pipe->createPosHOFeatureVector(inst, m, true, tmpfv);
+			probList[j] += fe->parameters->getScore(tmpfv);
 
 			if (gold) {
 				SegInstance& goldInst = gold->word[wordID].getCurrSeg();
 				double loss = 0.0;
 
 				if (word.currSegCandID == gold->word[wordID].currSegCandID
-						&& j != goldInst.element[j].currPosCandID) {
+						&& j != goldInst.element[i].currPosCandID) {
 					loss = 1.0;
 				}
 				probList[j] += loss;
@@ -53,6 +53,10 @@ public:
 		updateTimes = 0;
 	}
 
+	void setUpdateTimes(int upd) {
+		updateTimes = upd;
+	}
+
 	void initInst(DependencyInstance* inst, FeatureExtractor* fe);
 	void removeGoldInfo(DependencyInstance* inst);
 
@@ -18,7 +18,7 @@ void* work(void* threadid);
 void* outputThreadFunc(void* instance);
 void* decodeThreadFunc(void* instance);
 
-DevelopmentThread::DevelopmentThread() : isDevTesting(false) {
+DevelopmentThread::DevelopmentThread() : isDevTesting(false), depF1(0.0) {
 }
 
 DevelopmentThread::~DevelopmentThread() {
@@ -29,47 +29,40 @@ void* outputThreadFunc(void* instance) {
 
 	DependencyWriter writer(inst->options, inst->devoutfile);
 
-	bool allFinish = false;
-	int badcnt = 0;
-	while (!allFinish || !inst->id2Pred.empty()) {
-		bool find = true;
+	while (true) {
+		inst_ptr tmp_ptr;
 
 		pthread_mutex_lock( &inst->finishMutex );
 
-		if (inst->finishThreadNum >= inst->decodeThreadNum) {
-			allFinish = true;
+		// sleep until the next sentence in order is decoded or all decoders are done
+		while (inst->id2Pred.find(inst->currFinishID) == inst->id2Pred.end()
+				&& inst->finishThreadNum < inst->decodeThreadNum) {
+			pthread_cond_wait(&inst->finishCond, &inst->finishMutex);
 		}
 
 		if (inst->id2Pred.find(inst->currFinishID) != inst->id2Pred.end()) {
-			inst_ptr tmp_ptr = inst->id2Pred[inst->currFinishID];
-
-			writer.writeInstance(tmp_ptr.get());
+			tmp_ptr = inst->id2Pred[inst->currFinishID];
 			inst->id2Pred.erase(inst->currFinishID);
 			inst->currFinishID++;
+			pthread_cond_broadcast(&inst->spaceCond);
 		}
-		else {
-			find = false;
+		else if (!inst->id2Pred.empty()) {
+			cout << "output thread bug" << endl;
 		}
 
 		pthread_mutex_unlock( &inst->finishMutex );
 
-		if (allFinish && !inst->id2Pred.empty() && !find) {
-			cout << "output thread bug" << endl;
-			badcnt++;
-		}
-		else {
-			badcnt = 0;
-		}
-
-		if (!find) {
-			usleep(100 * 1000);
-		}
-		if (badcnt > 1000) {
-			cout << "too many bugs. break" << endl;
+		if (!tmp_ptr)
 			break;
-		}
+
+		// format off-lock, the writer thread does the file I/O
+		string buf;
+		writer.formatInstance(tmp_ptr.get(), buf);
+		writer.write(buf);
 	}
 
+	writer.close();
+
 	pthread_exit(NULL);
 	return NULL;
 }
@@ -92,6 +85,14 @@ void* decodeThreadFunc(void* instance) {
 		pthread_mutex_lock(&inst->processMutex);
 
 		currProcessID = inst->currProcessID;
+
+		// backpressure, stay within the reorder buffer of the output thread
+		pthread_mutex_lock( &inst->finishMutex );
+		while (currProcessID >= inst->currFinishID + REORDER_BUFFER_SIZE) {
+			pthread_cond_wait(&inst->spaceCond, &inst->finishMutex);
+		}
+		pthread_mutex_unlock( &inst->finishMutex );
+
 		inst->currProcessID++;
 		pred = reader.nextInstance();
 
@@ -103,6 +104,7 @@ void* decodeThreadFunc(void* instance) {
 			//cout << "check 1 " << inst->currProcessID << endl;
 			pthread_mutex_lock( &inst->finishMutex );
 			inst->finishThreadNum++;
+			pthread_cond_signal(&inst->finishCond);
 			pthread_mutex_unlock( &inst->finishMutex );
 			//cout << "check 2 " << inst->currProcessID << endl;
 
@@ -117,7 +119,7 @@ void* decodeThreadFunc(void* instance) {
 			pred->setInstIds(inst->sp->pipe, inst->options);
 			gold = *(pred.get());
 			decoder->removeGoldInfo(pred.get());		// make sure gold information is wiped at the beginning;
-			fe = boost::shared_ptr<FeatureExtractor>(new FeatureExtractor(pred.get(), inst->sp, params, inst->options->devThread));
+			fe = boost::shared_ptr<FeatureExtractor>(new FeatureExtractor(pred.get(), inst->sp, params, inst->options->devThread, true));
 			decoder->initInst(pred.get(), fe.get());	// remove gold info and init trees
 		}
 		//cout << "finish init " << inst->currProcessID << endl;
@@ -132,6 +134,7 @@ void* decodeThreadFunc(void* instance) {
 		pthread_mutex_lock( &inst->finishMutex );
 
 		inst->id2Pred[currProcessID] = pred;
+		pthread_cond_signal(&inst->finishCond);
 
 		inst->evaluate(pred.get(), &gold);
 
@@ -153,6 +156,9 @@ void* work(void* instance) {
 
 	Timer timer;
 
+	// average what the learner has not averaged yet, training goes on meanwhile
+	inst->sp->parameters->finishSnapshot();
+
 	if (inst->verbal) {
 		cout << "Processing Dev Sentence: ";
 		cout.flush();
@@ -167,6 +173,8 @@ void* work(void* instance) {
 	inst->currFinishID = 0;
 	inst->processMutex = PTHREAD_MUTEX_INITIALIZER;
 	inst->finishMutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_init(&inst->finishCond, NULL);
+	pthread_cond_init(&inst->spaceCond, NULL);
 
 	//inst->stats.resize(8);
 	inst->wordNum = 0;
@@ -179,13 +187,6 @@ void* work(void* instance) {
 	inst->predDepNum = 0;
 	inst->corrDepNum = 0;
 
-	// build output thread
-	inst->finishThreadNum = 0;
-	int rc = pthread_create(&inst->outputThread, NULL, outputThreadFunc, (void*)inst);
-	if (rc){
-		ThrowException("Error:unable to create output thread: " + to_string(rc));
-	}
-
 	if (inst->options->testingMode == DecodingMode::HillClimb) {
 		inst->decodeThreadNum = 1;
 	}
@@ -193,6 +194,14 @@ void* work(void* instance) {
 		inst->decodeThreadNum = inst->options->devThread;
 	}
 
+	// build output thread, after the number of decoders is known: it stops
+	// as soon as all of them are finished
+	inst->finishThreadNum = 0;
+	int rc = pthread_create(&inst->outputThread, NULL, outputThreadFunc, (void*)inst);
+	if (rc){
+		ThrowException("Error:unable to create output thread: " + to_string(rc));
+	}
+
 	inst->decodeThread.resize(inst->decodeThreadNum);
 	for (int i = 0; i < inst->decodeThreadNum; ++i) {
 		int rc = pthread_create(&inst->decodeThread[i], NULL, decodeThreadFunc, (void*)inst);
@@ -208,6 +217,9 @@ void* work(void* instance) {
 	pthread_join(inst->outputThread, NULL);
 	cout << "output thread finish" << endl;
 
+	pthread_cond_destroy(&inst->finishCond);
+	pthread_cond_destroy(&inst->spaceCond);
+
 	cout << endl;
 	cout << "-------------------------------------" << endl;
 	cout << endl;
@@ -241,6 +253,7 @@ void* work(void* instance) {
 	inst->reader.close();
 
 	double accuracy = (2 * deppre * deprec) / (deppre + deprec);		// dep f1 score
+	inst->depF1 = accuracy;
 
 	if (!inst->options->saveBestModel || accuracy > inst->options->bestScore - 1e-6) {
 		inst->options->bestScore = accuracy;
@@ -290,7 +303,7 @@ int DevelopmentThread::numSegWithoutPunc(DependencyInstance* inst) {
 	return num;
 }
 
-bool DevelopmentThread::isPunc(string& pos) {
+bool DevelopmentThread::isPunc(const string& pos) {
 	return pos == "PU";
 }
 
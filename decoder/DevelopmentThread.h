@@ -42,6 +42,8 @@ public:
 
 	pthread_mutex_t processMutex;
 	pthread_mutex_t finishMutex;
+	pthread_cond_t finishCond;		// a sentence is added to id2Pred or a decode thread exits
+	pthread_cond_t spaceCond;		// the output thread has written a sentence
 
 	double wordNum;
 	double corrWordSegNum;
@@ -52,6 +54,7 @@ public:
 	double goldDepNum;
 	double predDepNum;
 	double corrDepNum;
+	double depF1;			// of the last run
 
 	pthread_t workThread;
 	pthread_t outputThread;
@@ -66,7 +69,7 @@ public:
 	bool verbal;
 
 private:
-	bool isPunc(string& pos);
+	bool isPunc(const string& pos);
 	int numSegWithoutPunc(DependencyInstance* inst);
 	string normalize(string form);
 };
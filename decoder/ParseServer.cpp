@@ -0,0 +1,125 @@
+/*
+ * ParseServer.cpp
+ */
+
+#include "ParseServer.h"
+#include <boost/shared_ptr.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <string.h>
+#include "../io/DependencyReader.h"
+#include "../io/DependencyWriter.h"
+#include "../io/FdStreamBuf.h"
+#include "../util/Timer.h"
+
+namespace segparser {
+
+ParseServer::ParseServer(SegParser* sp) : sp(sp), options(sp->options) {
+}
+
+ParseServer::~ParseServer() {
+}
+
+void ParseServer::serve() {
+	if (options->socketPath.empty()) {
+		// parses go to stdout, main() sends the log to stderr in this mode
+		FdStreamBuf outBuf(STDOUT_FILENO);
+		ostream out(&outBuf);
+
+		cout << "Reading sentences from stdin" << endl;
+		int num = process(cin, out);
+		cout << "Parsed " << num << " sentences" << endl;
+	}
+	else {
+		serveSocket(options->socketPath);
+	}
+}
+
+void ParseServer::serveSocket(string path) {
+	// clients that go away should not kill the server
+	signal(SIGPIPE, SIG_IGN);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		ThrowException("cannot create socket");
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path))
+		ThrowException("socket path too long: " + path);
+	strcpy(addr.sun_path, path.c_str());
+
+	unlink(path.c_str());
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+		ThrowException("cannot bind socket " + path);
+	if (listen(fd, 16) != 0)
+		ThrowException("cannot listen on socket " + path);
+
+	cout << "Listening on " << path << endl;
+
+	while (true) {
+		int conn = accept(fd, NULL, NULL);
+		if (conn < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		// one connection at a time, the decoder is already multi-threaded
+		FdStreamBuf connBuf(conn);
+		istream in(&connBuf);
+		ostream out(&connBuf);
+		int num = process(in, out);
+		out.flush();
+		::close(conn);
+
+		cout << "Connection closed, parsed " << num << " sentences" << endl;
+	}
+
+	::close(fd);
+	unlink(path.c_str());
+}
+
+int ParseServer::process(istream& in, ostream& out) {
+	DependencyReader reader;
+	if (!options->jointSegPos)
+		reader.hasCandidate = false;
+	reader.isTrain = false;
+	reader.startReading(options, in);
+
+	DependencyWriter writer(options, out);
+
+	Parameters* params = sp->devParams;
+	DependencyDecoder* decoder = DependencyDecoder::createDependencyDecoder(options, options->testingMode, options->devThread, false);
+	decoder->initialize();
+
+	int num = 0;
+	Timer timer;
+
+	inst_ptr pred = reader.nextInstance();
+	while (pred) {
+		pred->setInstIds(sp->pipe, options);
+		DependencyInstance gold = *(pred.get());
+		decoder->removeGoldInfo(pred.get());
+		boost::shared_ptr<FeatureExtractor> fe(new FeatureExtractor(pred.get(), sp, params, options->devThread, true));
+		decoder->initInst(pred.get(), fe.get());
+
+		decoder->decode(pred.get(), &gold, fe.get());
+
+		writer.writeInstance(pred.get());
+		num++;
+
+		pred = reader.nextInstance();
+	}
+
+	decoder->shutdown();
+	delete decoder;
+
+	cout << "Parsing took: " << int(timer.stop()) << " ms" << endl;
+
+	return num;
+}
+
+} /* namespace segparser */
@@ -0,0 +1,37 @@
+/*
+ * ParseServer.h
+ */
+
+#ifndef PARSESERVER_H_
+#define PARSESERVER_H_
+
+#include <string>
+#include <iostream>
+#include "../SegParser.h"
+
+namespace segparser {
+
+using namespace std;
+
+class SegParser;
+
+// Long running parser. The model is loaded once, then sentences in the
+// lattice format are read from stdin or a unix socket and every parse is
+// written back as soon as it is decoded.
+class ParseServer {
+public:
+	ParseServer(SegParser* sp);
+	virtual ~ParseServer();
+
+	void serve();
+	int process(istream& in, ostream& out);
+
+	SegParser* sp;
+	Options* options;
+
+private:
+	void serveSocket(string path);
+};
+
+} /* namespace segparser */
+#endif /* PARSESERVER_H_ */
@@ -9,59 +9,209 @@
 #include "../util/StringUtils.h"
 #include <assert.h>
 #include <utility>
-#include <boost/regex.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <math.h>
 #include "../util/Constant.h"
+#include "../util/SerializationUtils.h"
 
 namespace segparser {
 
-DependencyReader::DependencyReader(Options* options, string file) : options(options) {
+DependencyReader::DependencyReader(Options* options, string file)
+	: in(&fin), options(options), mapped(NULL), mappedSize(0), mappedPos(0), ownsMapped(false), parallel(NULL), binFile(NULL) {
 	hasCandidate = true;
 	isTrain = false;
 	startReading(file);
 }
 
-DependencyReader::DependencyReader() : options(NULL) {
+DependencyReader::DependencyReader()
+	: in(&fin), options(NULL), mapped(NULL), mappedSize(0), mappedPos(0), ownsMapped(false), parallel(NULL), binFile(NULL) {
 	hasCandidate = true;
 	isTrain = false;
 }
 
 DependencyReader::~DependencyReader() {
+	close();
 }
 
 void DependencyReader::startReading(Options* options, string file) {
 	this->options = options;
-	fin.open(file.c_str());
+	startReading(file);
 }
 
 void DependencyReader::startReading(string file) {
+	if (openCompiled(file))
+		return;
+	if (options && options->useMmap && openMapped(file))
+		return;
 	fin.open(file.c_str());
+	in = &fin;
+}
+
+void DependencyReader::startReading(Options* options, istream& stream) {
+	// e.g. stdin or a socket, read line by line as sentences arrive
+	this->options = options;
+	in = &stream;
+}
+
+void DependencyReader::startReading(Options* options, const char* data, size_t size) {
+	this->options = options;
+	mapped = data;
+	mappedSize = size;
+	mappedPos = 0;
+	ownsMapped = false;
+}
+
+bool DependencyReader::finished() {
+	if (mapped)
+		return mappedPos >= mappedSize;
+	return in->eof();
+}
+
+bool DependencyReader::openCompiled(string& file) {
+	FILE* fs = fopen(file.c_str(), "rb");
+	if (!fs)
+		return false;
+
+	int magic = 0;
+	if (!ReadInteger(fs, &magic) || magic != COMPILED_CORPUS_MAGIC) {
+		fclose(fs);
+		return false;
+	}
+
+	int version = 0;
+	CHECK(ReadInteger(fs, &version));
+	if (version != COMPILED_CORPUS_VERSION)
+		ThrowException("unsupported compiled corpus version in " + file);
+
+	uint64_t dataOffset = 0;
+	CHECK(ReadBool(fs, &binHasCandidate));
+	CHECK(ReadBool(fs, &binIsTrain));
+	CHECK(ReadUINT64(fs, &binDictKey));
+	CHECK(ReadUINT64(fs, &dataOffset));
+	binDataOffset = dataOffset;
+	binDictOffset = ftell(fs);
+	binChecked = false;
+	binFile = fs;
+	return true;
+}
+
+bool DependencyReader::isCompiled() {
+	return binFile != NULL;
+}
+
+void DependencyReader::readDictionary(Alphabet* typeAlphabet, Alphabet* posAlphabet, Alphabet* lexAlphabet) {
+	assert(binFile);
+	fseek(binFile, binDictOffset, SEEK_SET);
+	typeAlphabet->readObject(binFile);
+	posAlphabet->readObject(binFile);
+	lexAlphabet->readObject(binFile);
+	binChecked = false;		// seek to the instances again on next read
+}
+
+bool DependencyReader::openMapped(string& file) {
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		::close(fd);
+		return false;
+	}
+
+	mappedSize = st.st_size;
+	mappedPos = 0;
+	if (mappedSize == 0) {
+		// nothing to map, but still read through the mapped path
+		mapped = "";
+		ownsMapped = false;
+		::close(fd);
+		return true;
+	}
+
+	void* addr = mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		mappedSize = 0;
+		return false;
+	}
+	madvise(addr, mappedSize, MADV_SEQUENTIAL);
+	mapped = (const char*)addr;
+	ownsMapped = true;
+	return true;
 }
 
 void DependencyReader::close() {
+	if (parallel) {
+		delete parallel;
+		parallel = NULL;
+	}
 	if (fin.is_open())
 		fin.close();
+	in = &fin;
+	if (mapped) {
+		if (ownsMapped)
+			munmap((void*)mapped, mappedSize);
+		mapped = NULL;
+		mappedSize = 0;
+		mappedPos = 0;
+		ownsMapped = false;
+	}
+	lineBuffer.clear();
+	if (binFile) {
+		fclose(binFile);
+		binFile = NULL;
+	}
+	symbols.reset();
+}
+
+bool DependencyReader::nextLine(StringPiece& line) {
+	// behaves like getline: returns an empty line at the end of the input
+	if (mapped) {
+		if (mappedPos >= mappedSize) {
+			line = StringPiece();
+			return false;
+		}
+		const char* st = mapped + mappedPos;
+		const char* en = (const char*)memchr(st, '\n', mappedSize - mappedPos);
+		if (!en)
+			en = mapped + mappedSize;
+		line = StringPiece(st, en - st);
+		mappedPos = en - mapped + 1;
+		return true;
+	}
+	else {
+		// deque never moves its elements on push_back, so earlier lines stay valid
+		lineBuffer.push_back(string());
+		getline(*in, lineBuffer.back());
+		line = StringPiece(lineBuffer.back());
+		return !in->fail();
+	}
 }
 
-HeadIndex DependencyReader::parseHeadIndex(string str) {
-	unsigned int pos = str.find("/");
-	assert(pos != string::npos);
-	int word = atoi(str.substr(0, pos).c_str());
-	int seg = atoi(str.substr(pos + 1).c_str());
+HeadIndex DependencyReader::parseHeadIndex(const StringPiece& str) {
+	size_t pos = str.find('/');
+	assert(pos != StringPiece::npos);
+	int word = str.substr(0, pos).toInt();
+	int seg = str.substr(pos + 1).toInt();
 	return HeadIndex(word, seg);
 }
 
-void DependencyReader::addGoldSegElement(WordInstance* word, string form, string lemma, string pos,
-		string morphStr, int segid, int hwordid, int hsegid, string lab) {
-	word->goldForm.push_back(form);
-	word->goldLemma.push_back(lemma);
-	word->goldPos.push_back(pos);
+void DependencyReader::addGoldSegElement(WordInstance* word, const StringPiece& form, const StringPiece& lemma, const StringPiece& pos,
+		const StringPiece& morphStr, int segid, int hwordid, int hsegid, const string& lab) {
+	word->goldForm.push_back(symbols->intern(form));
+	word->goldLemma.push_back(symbols->intern(lemma));
+	word->goldPos.push_back(symbols->intern(pos));
 	word->goldDep.push_back(HeadIndex(hwordid, hsegid));
-	word->goldLab.push_back(lab);
+	word->goldLab.push_back(symbols->intern(lab));
 	word->goldMorphIndex = -1;
 	word->goldAlIndex = -1;
 
 	if (morphStr != "_") {
-		vector<string> data;
+		vector<StringPiece> data;
 		StringSplit(morphStr, "|", &data);
 
 		if (word->goldAlIndex == -1 && data[0][data[0].length() - 1] == 'y') {
@@ -72,15 +222,15 @@ void DependencyReader::addGoldSegElement(WordInstance* word, string form, string
 			assert(data.size() == 4);
 			bool hasMorphInfo = false;
 			for (int i = 1; i < 4; ++i) {
-				string val = data[i].substr(data[i].find_last_of("=") + 1, string::npos);
+				StringPiece val = data[i].substr(data[i].rfind('=') + 1);
 				if (val != "na" && val != "NA")
 					hasMorphInfo = true;
 			}
 			if (hasMorphInfo) {
 				word->goldMorph.clear();
 				for (int i = 1; i < 4; ++i) {
-					string val = data[i].substr(data[i].find_last_of("=") + 1, string::npos);
-					word->goldMorph.push_back(val);
+					StringPiece val = data[i].substr(data[i].rfind('=') + 1);
+					word->goldMorph.push_back(symbols->intern(val));
 				}
 				word->goldMorphIndex = segid;
 			}
@@ -129,7 +279,7 @@ void DependencyReader::addGoldSegToCand(WordInstance* word) {
 	// add the gold seg in to seg candidate if not exist (with prob 0)
 	double prob = hasCandidate ? (isTrain ? 0.3 : 0.0) : 1.0;
 
-	string goldSegStr = word->goldForm[0];
+	string goldSegStr = word->goldForm[0].toString();
 	for (unsigned int i = 1; i < word->goldForm.size(); ++i)
 		goldSegStr += "+" + word->goldForm[i];
 
@@ -146,7 +296,7 @@ void DependencyReader::addGoldSegToCand(WordInstance* word) {
 
 		SegInstance segInst;
 		segInst.prob = prob;
-		segInst.segStr = goldSegStr;
+		segInst.segStr = symbols->intern(goldSegStr);
 		segInst.morph = word->goldMorph;
 		segInst.morphIndex = word->goldMorphIndex;
 		segInst.AlIndex = word->goldAlIndex;
@@ -182,7 +332,7 @@ void DependencyReader::addGoldSegToCand(WordInstance* word) {
 		for (unsigned int i = 0; i < word->goldForm.size(); ++i) {
 			assert(word->goldForm[i].compare(segInst.element[i].form) == 0);
 			segInst.element[i].lemma = word->goldLemma[i];
-			string goldPos = word->goldPos[i];
+			Symbol goldPos = word->goldPos[i];
 			unsigned int goldPosID = 0;
 			SegElement& ele = segInst.element[i];
 			for (; goldPosID < ele.candPos.size(); ++goldPosID) {
@@ -219,24 +369,28 @@ void DependencyReader::addGoldSegToCand(WordInstance* word) {
 	}
 }
 
-void DependencyReader::addSegCand(WordInstance* word, string str) {
-	vector<string> dataList;
+void DependencyReader::addSegCand(WordInstance* word, const StringPiece& str) {
+	vector<StringPiece> dataList;
 	StringSplit(str, "||", &dataList);
 	if (dataList.size() != 5)
-		cout << str << endl;
+		cout << str.toString() << endl;
 	assert(dataList.size() == 5);
 	SegInstance segInst;
 
-	double segProb = atof(dataList[4].c_str());
+	double segProb = dataList[4].toDouble();
 	segInst.prob = segProb;
 
-	int AlIndex = atoi(dataList[1].c_str());
+	int AlIndex = dataList[1].toInt();
 	segInst.AlIndex = AlIndex;
 
-	int morphIndex = atoi(dataList[2].c_str());
+	int morphIndex = dataList[2].toInt();
 	segInst.morphIndex = morphIndex;
 
-	StringSplit(dataList[3], "/", &segInst.morph);
+	vector<StringPiece> morphList;
+	StringSplit(dataList[3], "/", &morphList);
+	segInst.morph.resize(morphList.size());
+	for (unsigned int i = 0; i < morphList.size(); ++i)
+		segInst.morph[i] = symbols->intern(morphList[i]);
 
 	bool hasMorphValue = false;
 	for (unsigned int i = 0; i < segInst.morph.size(); ++i) {
@@ -250,17 +404,18 @@ void DependencyReader::addSegCand(WordInstance* word, string str) {
 		segInst.morph.clear();
 	}
 
-	string segStr = dataList[0];
-	vector<string> segList;
-	StringSplit(segStr, "&&", &segList);
+	vector<StringPiece> segList;
+	StringSplit(dataList[0], "&&", &segList);
 
+	vector<StringPiece> posList;
+	string segStr;
 	segInst.element.resize(segList.size());
 	for (unsigned int i = 0; i < segList.size(); ++i) {
 		SegElement& curr = segInst.element[i];
-		vector<string> posList;
+		posList.clear();
 		StringSplit(segList[i], "@#", &posList);
-		curr.form = posList[0];		// normalize is done when set inst ids
-		curr.lemma = posList[1];
+		curr.form = symbols->intern(posList[0]);		// normalize is done when set inst ids
+		curr.lemma = symbols->intern(posList[1]);
 		curr.candPos.resize(posList.size() - 2);
 		curr.candPosid.resize(posList.size() - 2);
 		curr.candDetPosid.resize(posList.size() - 2);
@@ -268,50 +423,87 @@ void DependencyReader::addSegCand(WordInstance* word, string str) {
 		curr.candSpecialPos.resize(posList.size() - 2);
 
 		for (unsigned int j = 2; j < posList.size(); ++j) {
-			int pos = posList[j].find_last_of("_");
-			curr.candPos[j - 2] = posList[j].substr(0, pos);
-			curr.candProb[j - 2] = atof(posList[j].substr(pos + 1).c_str());
+			size_t pos = posList[j].rfind('_');
+			curr.candPos[j - 2] = symbols->intern(posList[j].substr(0, pos));
+			curr.candProb[j - 2] = posList[j].substr(pos + 1).toDouble();
 		}
 
 		if (i > 0)
-			segInst.segStr += "+";
-		segInst.segStr += curr.form;
+			segStr += "+";
+		segStr += curr.form;
 	}
+	segInst.segStr = symbols->intern(segStr);
 
 	word->candSeg.push_back(move(segInst));
 }
 
 void DependencyReader::concatSegStr(WordInstance* word) {
-	word->wordStr = "";
+	string wordStr;
 	for (unsigned int i = 0; i < word->goldForm.size(); ++i) {
-		word->wordStr += word->goldForm[i];
+		wordStr += word->goldForm[i];
 	}
+	word->wordStr = symbols->intern(wordStr);
 }
 
 inst_ptr DependencyReader::nextInstance() {
 
-	if (fin.eof()) {
+	if (!symbols)
+		symbols.reset(new SymbolTable());
+
+	if (binFile) {
+		if (!binChecked) {
+			if (binHasCandidate != hasCandidate || binIsTrain != isTrain)
+				ThrowException("compiled corpus was created with different reader settings (joint/train)");
+			fseek(binFile, binDataOffset, SEEK_SET);
+			binChecked = true;
+		}
+
+		bool hasNext = false;
+		if (!ReadBool(binFile, &hasNext) || !hasNext) {
+			return inst_ptr((DependencyInstance*)NULL);
+		}
+
+		inst_ptr s(new DependencyInstance());
+		s->readObject(binFile, symbols.get());
+		s->dictKey = binDictKey;
+
+		s->constructConversionList();
+		s->setOptSegPosCount();
+		s->buildChild();
+
+		return s;
+	}
+
+	if (ownsMapped && options && options->readThread > 1) {
+		if (!parallel)
+			parallel = new ParallelReader(options, mapped, mappedSize, hasCandidate, isTrain, options->readThread, symbols);
+		return parallel->nextInstance();
+	}
+
+	if (!mapped && in->eof()) {
 		return inst_ptr((DependencyInstance*)NULL);
 	}
 
-	string str;
-	getline(fin, str);
+	lineBuffer.clear();
+
+	StringPiece str;
+	nextLine(str);
 	if (str.empty()) {
 		return inst_ptr((DependencyInstance*)NULL);
 	}
 
 	inst_ptr s(new DependencyInstance());
-	vector<string> data;
+	vector<StringPiece> data;
 	while (!str.empty()) {
 		data.push_back(str);
-		getline(fin, str);
+		nextLine(str);
 	}
 
 	// get sentence length and seg counts
 	// word id starts from 1, seg starts from 0
 	int len = 0;
 	for (unsigned int i = 0; i < data.size(); ++i) {
-		int pos = data[i].find("\t");
+		size_t pos = data[i].find('\t');
 		HeadIndex hi = parseHeadIndex(data[i].substr(0, pos));
 		len = hi.hWord + 1;	// include root
 	}
@@ -325,19 +517,16 @@ inst_ptr DependencyReader::nextInstance() {
 	addSegCand(&s->word[0], "<root>@#<root>@#<root-POS>_1.0||-1||0||_||1.0");
 
 	// process each line
+	vector<StringPiece> line;
+	string lab = "<no-type>";
 	for (unsigned int i = 0; i < data.size(); ++i) {
-		vector<string> line;
+		line.clear();
 		StringSplit(data[i], "\t", &line);
 
 		HeadIndex id = parseHeadIndex(line[0]);
-		string word = line[1];
-		string lemma = line[2];
-		string pos = line[3];
-		string morphStr = line[5];
 		HeadIndex head = parseHeadIndex(line[6]);
-		string lab = "<no-type>";
 
-		addGoldSegElement(&s->word[id.hWord], word, lemma, pos, morphStr, id.hSeg, head.hWord, head.hSeg, lab);
+		addGoldSegElement(&s->word[id.hWord], line[1], line[2], line[3], line[5], id.hSeg, head.hWord, head.hSeg, lab);
 		assert((unsigned int)id.hSeg + 1 == s->word[id.hWord].goldForm.size());
 	}
 
@@ -348,20 +537,21 @@ inst_ptr DependencyReader::nextInstance() {
 
 	// process segmentation candidate
 	if (hasCandidate) {
+		vector<StringPiece> segCand;
 		for (int i = 1; i < len; ++i) {
-			getline(fin, str);
-			vector<string> segCand;
+			nextLine(str);
+			segCand.clear();
 			StringSplit(str, "\t", &segCand);
-			if (s->word[i].wordStr != segCand[0]) {
-				cout << str << endl;
-				cout << s->word[i].wordStr << " " << segCand[0] << endl;
+			if (StringPiece(s->word[i].wordStr) != segCand[0]) {
+				cout << str.toString() << endl;
+				cout << s->word[i].wordStr << " " << segCand[0].toString() << endl;
 			}
-			assert(s->word[i].wordStr.compare(segCand[0]) == 0);
+			assert(StringPiece(s->word[i].wordStr) == segCand[0]);
 			for (unsigned int j = 1; j < segCand.size(); ++j) {
 				addSegCand(&s->word[i], segCand[j]);
 			}
 		}
-		getline(fin, str);
+		nextLine(str);
 		assert(str.empty());
 	}
 
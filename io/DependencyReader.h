@@ -9,8 +9,11 @@
 #define DEPENDENCYREADER_H_
 
 #include <fstream>
+#include <deque>
 #include "../Options.h"
 #include "../DependencyInstance.h"
+#include "../util/StringPiece.h"
+#include "ParallelReader.h"
 
 namespace segparser {
 
@@ -24,22 +27,59 @@ public:
 
 	void startReading(Options* options, string file);
 	void startReading(string file);
+	void startReading(Options* options, const char* data, size_t size);
+	void startReading(Options* options, istream& stream);
 	void close();
+	bool finished();
 	inst_ptr nextInstance();
 
+	// compiled corpus, see DependencyPipe::compileCorpus
+	bool isCompiled();
+	void readDictionary(Alphabet* typeAlphabet, Alphabet* posAlphabet, Alphabet* lexAlphabet);
+
 	bool hasCandidate;
 	bool isTrain;
 
+	// the strings of the instances, created with the first instance and
+	// released by close. keep it while the instances are used after that
+	boost::shared_ptr<SymbolTable> symbols;
+
 private:
 	ifstream fin;
+	istream* in;					// fin, or a stream given to startReading
 	Options* options;
 
-	HeadIndex parseHeadIndex(string str);
-	void addGoldSegElement(WordInstance* word, string form, string lemma, string pos,
-			string morphStr, int segid, int hwordid, int hsegid, string lab);
+	// memory mapped input, used instead of fin when options->useMmap is set
+	const char* mapped;
+	size_t mappedSize;
+	size_t mappedPos;
+	bool ownsMapped;				// false when reading a range of another reader's buffer
+
+	// parses the mapped input on options->readThread threads
+	ParallelReader* parallel;
+
+	deque<string> lineBuffer;		// owns the lines of the current sentence when reading from fin
+
+	// compiled corpus input
+	FILE* binFile;
+	uint64_t binDictKey;
+	bool binHasCandidate;
+	bool binIsTrain;
+	long binDataOffset;
+	long binDictOffset;
+	bool binChecked;
+
+	bool openCompiled(string& file);
+
+	bool openMapped(string& file);
+	bool nextLine(StringPiece& line);
+
+	HeadIndex parseHeadIndex(const StringPiece& str);
+	void addGoldSegElement(WordInstance* word, const StringPiece& form, const StringPiece& lemma, const StringPiece& pos,
+			const StringPiece& morphStr, int segid, int hwordid, int hsegid, const string& lab);
 	void addGoldSegToCand(WordInstance* word);
 	void normalizeProb(WordInstance* word);
-	void addSegCand(WordInstance* word, string str);
+	void addSegCand(WordInstance* word, const StringPiece& str);
 	string normalize(string s);
 	void concatSegStr(WordInstance* word);
 };
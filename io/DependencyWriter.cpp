@@ -6,42 +6,154 @@
  */
 
 #include "DependencyWriter.h"
+#include "../util/Constant.h"
+#include "../util/StringUtils.h"
+#include <sys/time.h>
+#include <errno.h>
 
 namespace segparser {
 
-DependencyWriter::DependencyWriter(Options* options) : options(options) {
+void* ioThreadFunc(void* instance);
+
+DependencyWriter::DependencyWriter(Options* options) : async(false), stop(false), out(&fout), options(options) {
 }
 
-DependencyWriter::DependencyWriter(Options* options, string file) : options(options) {
+DependencyWriter::DependencyWriter(Options* options, string file) : async(false), stop(false), out(&fout), options(options) {
 	startWriting(file);
 }
 
+DependencyWriter::DependencyWriter(Options* options, ostream& stream) : async(false), stop(false), out(&stream), options(options) {
+}
+
 DependencyWriter::~DependencyWriter() {
+	close();
+}
+
+void* ioThreadFunc(void* instance) {
+	DependencyWriter* writer = (DependencyWriter*)instance;
+
+	string block;
+	bool stop = false;
+	while (!stop) {
+		pthread_mutex_lock(&writer->ioMutex);
+		if (!writer->stop && writer->pending.size() < WRITER_FLUSH_SIZE) {
+			// wake up on a full block, on close, or when the interval expires
+			struct timeval now;
+			gettimeofday(&now, NULL);
+			long usec = now.tv_usec + WRITER_FLUSH_INTERVAL * 1000L;
+			struct timespec timeout;
+			timeout.tv_sec = now.tv_sec + usec / 1000000;
+			timeout.tv_nsec = (usec % 1000000) * 1000;
+			int rc = 0;
+			while (!writer->stop && writer->pending.size() < WRITER_FLUSH_SIZE && rc != ETIMEDOUT) {
+				rc = pthread_cond_timedwait(&writer->pendingCond, &writer->ioMutex, &timeout);
+			}
+		}
+		block.swap(writer->pending);
+		stop = writer->stop;
+		pthread_cond_broadcast(&writer->spaceCond);
+		pthread_mutex_unlock(&writer->ioMutex);
+
+		if (!block.empty()) {
+			writer->fout.write(block.data(), block.size());
+			writer->fout.flush();
+			block.clear();
+		}
+	}
+
+	pthread_exit(NULL);
+	return NULL;
 }
 
 void DependencyWriter::startWriting(string file) {
 	fout.open(file.c_str());
+	out = &fout;
+
+	async = true;
+	stop = false;
+	pending.clear();
+	pthread_mutex_init(&ioMutex, NULL);
+	pthread_cond_init(&pendingCond, NULL);
+	pthread_cond_init(&spaceCond, NULL);
+	int rc = pthread_create(&ioThread, NULL, ioThreadFunc, (void*)this);
+	if (rc) {
+		ThrowException("Error:unable to create writer thread: " + to_string(rc));
+	}
 }
 
 void DependencyWriter::close() {
+	if (async) {
+		// write out everything that is still pending
+		pthread_mutex_lock(&ioMutex);
+		stop = true;
+		pthread_cond_signal(&pendingCond);
+		pthread_mutex_unlock(&ioMutex);
+		pthread_join(ioThread, NULL);
+
+		pthread_mutex_destroy(&ioMutex);
+		pthread_cond_destroy(&pendingCond);
+		pthread_cond_destroy(&spaceCond);
+		async = false;
+	}
 	if (fout.is_open())
 		fout.close();
 }
 
-void DependencyWriter::writeInstance(DependencyInstance* inst) {
+void DependencyWriter::formatInstance(DependencyInstance* inst, string& buf) {
 	for (int i = 1; i < inst->numWord; ++i) {
 		WordInstance& word = inst->word[i];
 		SegInstance& segInst = word.getCurrSeg();
 
 		for (int j = 0; j < segInst.size(); ++j) {
-			fout << i << "/" << j << "\t" << segInst.element[j].form << "\t" << segInst.element[j].form << "\t";
-			string pos = segInst.element[j].candPos[segInst.element[j].currPosCandID];
-			fout << pos << "\t" << pos << "\t_\t";
-			fout << segInst.element[j].dep << "\t" << word.currSegCandID << "\t" << segInst.element[j].currPosCandID << "\t_\n";
+			SegElement& ele = segInst.element[j];
+			const string& pos = ele.candPos[ele.currPosCandID];
+			buf += to_string(i);
+			buf += '/';
+			buf += to_string(j);
+			buf += '\t';
+			buf += ele.form;
+			buf += '\t';
+			buf += ele.form;
+			buf += '\t';
+			buf += pos;
+			buf += '\t';
+			buf += pos;
+			buf += "\t_\t";
+			buf += to_string(ele.dep.hWord);
+			buf += '/';
+			buf += to_string(ele.dep.hSeg);
+			buf += '\t';
+			buf += to_string(word.currSegCandID);
+			buf += '\t';
+			buf += to_string(ele.currPosCandID);
+			buf += "\t_\n";
 		}
 	}
-	fout << endl;
-	fout.flush();
+	buf += '\n';
+}
+
+void DependencyWriter::write(const string& buf) {
+	if (!async) {
+		// e.g. the parse server, the client waits for every sentence
+		out->write(buf.data(), buf.size());
+		out->flush();
+		return;
+	}
+
+	pthread_mutex_lock(&ioMutex);
+	while (pending.size() >= WRITER_MAX_PENDING) {
+		pthread_cond_wait(&spaceCond, &ioMutex);
+	}
+	pending += buf;
+	if (pending.size() >= WRITER_FLUSH_SIZE)
+		pthread_cond_signal(&pendingCond);
+	pthread_mutex_unlock(&ioMutex);
+}
+
+void DependencyWriter::writeInstance(DependencyInstance* inst) {
+	string buf;
+	formatInstance(inst, buf);
+	write(buf);
 }
 
 } /* namespace segparser */
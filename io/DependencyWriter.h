@@ -9,6 +9,7 @@
 #define DEPENDENCYWRITER_H_
 
 #include <fstream>
+#include <pthread.h>
 #include "../DependencyInstance.h"
 #include "../Options.h"
 
@@ -18,14 +19,30 @@ class DependencyWriter {
 public:
 	DependencyWriter(Options* options);
 	DependencyWriter(Options* options, string file);
+	DependencyWriter(Options* options, ostream& stream);
 	virtual ~DependencyWriter();
 
 	void startWriting(string file);
 	void close();
 	void writeInstance(DependencyInstance* inst);
 
-private:
+	// formatting does not touch the writer, so it can be done off-lock
+	void formatInstance(DependencyInstance* inst, string& buf);
+	void write(const string& buf);
+
+	// background I/O thread, only used when writing to a file
+	bool async;
+	string pending;				// formatted sentences not handed to the I/O thread yet
+	bool stop;
+	pthread_t ioThread;
+	pthread_mutex_t ioMutex;
+	pthread_cond_t pendingCond;		// pending is large enough or the writer is closed
+	pthread_cond_t spaceCond;		// pending has been taken by the I/O thread
+
 	ofstream fout;
+
+private:
+	ostream* out;			// fout, or a stream given to the constructor
 	Options* options;
 
 };
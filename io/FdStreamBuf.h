@@ -0,0 +1,80 @@
+/*
+ * FdStreamBuf.h
+ */
+
+#ifndef FDSTREAMBUF_H_
+#define FDSTREAMBUF_H_
+
+#include <streambuf>
+#include <unistd.h>
+#include <errno.h>
+
+namespace segparser {
+
+using namespace std;
+
+// buffered stream over a file descriptor (e.g. a socket), so that it can be
+// used with DependencyReader and DependencyWriter
+class FdStreamBuf : public streambuf {
+public:
+	FdStreamBuf(int fd) : fd(fd) {
+		setg(inBuf, inBuf, inBuf);
+		setp(outBuf, outBuf + BUF_SIZE);
+	}
+
+	virtual ~FdStreamBuf() {
+		sync();
+	}
+
+protected:
+	int_type underflow() {
+		if (gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		ssize_t n;
+		do {
+			n = read(fd, inBuf, BUF_SIZE);
+		} while (n < 0 && errno == EINTR);
+		if (n <= 0)
+			return traits_type::eof();
+		setg(inBuf, inBuf, inBuf + n);
+		return traits_type::to_int_type(*gptr());
+	}
+
+	int_type overflow(int_type c) {
+		if (flushOut() < 0)
+			return traits_type::eof();
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	int sync() {
+		return flushOut();
+	}
+
+private:
+	static const int BUF_SIZE = 1 << 16;
+
+	int fd;
+	char inBuf[BUF_SIZE];
+	char outBuf[BUF_SIZE];
+
+	int flushOut() {
+		char* p = pbase();
+		while (p < pptr()) {
+			ssize_t n = write(fd, p, pptr() - p);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				return -1;
+			p += n;
+		}
+		setp(outBuf, outBuf + BUF_SIZE);
+		return 0;
+	}
+};
+
+} /* namespace segparser */
+#endif /* FDSTREAMBUF_H_ */
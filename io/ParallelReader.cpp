@@ -0,0 +1,181 @@
+/*
+ * ParallelReader.cpp
+ */
+
+#include "ParallelReader.h"
+#include "DependencyReader.h"
+#include "../util/StringUtils.h"
+#include <string.h>
+#include <assert.h>
+
+namespace segparser {
+
+void* parseThreadFunc(void* instance) {
+	ParallelReader* pr = (ParallelReader*)instance;
+
+	while (true) {
+		pthread_mutex_lock(&pr->chunkMutex);
+		while (!pr->stop && pr->nextChunk < pr->chunks.size()
+				&& pr->nextChunk >= pr->currChunk + pr->maxAhead) {
+			pthread_cond_wait(&pr->consumedCond, &pr->chunkMutex);
+		}
+		if (pr->stop || pr->nextChunk >= pr->chunks.size()) {
+			pthread_mutex_unlock(&pr->chunkMutex);
+			break;
+		}
+		int id = pr->nextChunk;
+		pr->nextChunk++;
+		ReaderChunk& chunk = pr->chunks[id];
+		pthread_mutex_unlock(&pr->chunkMutex);
+
+		DependencyReader reader;
+		reader.hasCandidate = pr->hasCandidate;
+		reader.isTrain = pr->isTrain;
+		reader.symbols = pr->symbols;
+		reader.startReading(pr->options, pr->data + chunk.start, chunk.end - chunk.start);
+
+		vector<inst_ptr> inst;
+		inst_ptr s = reader.nextInstance();
+		while (s) {
+			inst.push_back(s);
+			s = reader.nextInstance();
+		}
+		bool terminated = !reader.finished();
+		reader.close();
+
+		pthread_mutex_lock(&pr->chunkMutex);
+		chunk.inst.swap(inst);
+		chunk.terminated = terminated;
+		chunk.done = true;
+		pthread_cond_broadcast(&pr->parsedCond);
+		pthread_mutex_unlock(&pr->chunkMutex);
+	}
+
+	pthread_exit(NULL);
+	return NULL;
+}
+
+ParallelReader::ParallelReader(Options* options, const char* data, size_t size, bool hasCandidate, bool isTrain, int threadNum,
+		boost::shared_ptr<SymbolTable> symbols)
+	: options(options), data(data), hasCandidate(hasCandidate), isTrain(isTrain), symbols(symbols),
+	  nextChunk(0), currChunk(0), currInst(0), stop(false) {
+	splitChunks(size, threadNum);
+	maxAhead = threadNum * 4;
+
+	pthread_mutex_init(&chunkMutex, NULL);
+	pthread_cond_init(&parsedCond, NULL);
+	pthread_cond_init(&consumedCond, NULL);
+
+	threadID.resize(threadNum);
+	for (int i = 0; i < threadNum; ++i) {
+		int rc = pthread_create(&threadID[i], NULL, parseThreadFunc, (void*)this);
+		if (rc) {
+			ThrowException("Error:unable to create parse thread: " + to_string(rc));
+		}
+	}
+}
+
+ParallelReader::~ParallelReader() {
+	pthread_mutex_lock(&chunkMutex);
+	stop = true;
+	pthread_cond_broadcast(&consumedCond);
+	pthread_mutex_unlock(&chunkMutex);
+
+	for (unsigned int i = 0; i < threadID.size(); ++i) {
+		pthread_join(threadID[i], NULL);
+	}
+
+	pthread_mutex_destroy(&chunkMutex);
+	pthread_cond_destroy(&parsedCond);
+	pthread_cond_destroy(&consumedCond);
+}
+
+size_t ParallelReader::skipBlock(size_t pos, size_t size) {
+	// lines up to and including the next empty line
+	while (pos < size) {
+		const char* nl = (const char*)memchr(data + pos, '\n', size - pos);
+		if (!nl)
+			return size;
+		bool empty = nl == data + pos;
+		pos = nl - data + 1;
+		if (empty)
+			break;
+	}
+	return pos;
+}
+
+bool ParallelReader::isGoldLine(size_t pos, size_t size) {
+	// a gold line starts with the word/seg index
+	const char* st = data + pos;
+	const char* en = (const char*)memchr(st, '\t', size - pos);
+	if (!en)
+		return false;
+	const char* nl = (const char*)memchr(st, '\n', en - st);
+	return !nl && memchr(st, '/', en - st) != NULL;
+}
+
+void ParallelReader::splitChunks(size_t size, int threadNum) {
+	// a chunk ends right after a whole sentence. a sentence is the gold
+	// block and, with candidates, the candidate block, each followed by an
+	// empty line. an empty line alone cannot be used as the boundary
+	size_t chunkSize = max((size_t)(1 << 16), size / (threadNum * 16));
+	int blockNum = hasCandidate ? 2 : 1;
+	size_t start = 0;
+	size_t pos = 0;
+	while (start < size) {
+		size_t end = size;
+		while (pos < size) {
+			if (data[pos] == '\n') {
+				// the reader stops at an empty line where a sentence should start
+				pos = size;
+				break;
+			}
+			for (int i = 0; i < blockNum; ++i)
+				pos = skipBlock(pos, size);
+			if (pos - start >= chunkSize) {
+				end = pos;
+				break;
+			}
+		}
+		if (end < size && !isGoldLine(end, size))
+			ThrowException("input is not split at a sentence boundary, check the candidate blocks");
+		chunks.push_back(ReaderChunk(start, end));
+		start = end;
+	}
+}
+
+inst_ptr ParallelReader::nextInstance() {
+	inst_ptr ret;
+
+	pthread_mutex_lock(&chunkMutex);
+	while (currChunk < chunks.size()) {
+		ReaderChunk& chunk = chunks[currChunk];
+		while (!chunk.done) {
+			pthread_cond_wait(&parsedCond, &chunkMutex);
+		}
+
+		if (currInst < chunk.inst.size()) {
+			ret = chunk.inst[currInst];
+			chunk.inst[currInst].reset();
+			currInst++;
+			break;
+		}
+
+		if (chunk.terminated) {
+			// same as the sequential reader, nothing after this point is read
+			currChunk = chunks.size();
+			stop = true;
+		}
+		else {
+			vector<inst_ptr>().swap(chunk.inst);
+			currChunk++;
+		}
+		currInst = 0;
+		pthread_cond_broadcast(&consumedCond);
+	}
+	pthread_mutex_unlock(&chunkMutex);
+
+	return ret;
+}
+
+} /* namespace segparser */
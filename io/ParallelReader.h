@@ -0,0 +1,67 @@
+/*
+ * ParallelReader.h
+ */
+
+#ifndef PARALLELREADER_H_
+#define PARALLELREADER_H_
+
+#include <vector>
+#include <pthread.h>
+#include "../Options.h"
+#include "../DependencyInstance.h"
+
+namespace segparser {
+
+using namespace std;
+
+// a range of whole sentences in the input buffer
+class ReaderChunk {
+public:
+	size_t start;
+	size_t end;
+
+	vector<inst_ptr> inst;
+	bool done;
+	bool terminated;		// the input ends inside this chunk (empty line at a sentence start)
+
+	ReaderChunk(size_t start, size_t end) : start(start), end(end), done(false), terminated(false) {}
+};
+
+// Parses a memory mapped lattice file on several threads. The buffer is
+// split into sentence-aligned chunks, each chunk is parsed by a
+// DependencyReader over that range, and instances are returned in the
+// original order. Parsing runs at most a few chunks ahead of the consumer.
+class ParallelReader {
+public:
+	ParallelReader(Options* options, const char* data, size_t size, bool hasCandidate, bool isTrain, int threadNum,
+			boost::shared_ptr<SymbolTable> symbols);
+	virtual ~ParallelReader();
+
+	inst_ptr nextInstance();
+
+	Options* options;
+	const char* data;
+	bool hasCandidate;
+	bool isTrain;
+	boost::shared_ptr<SymbolTable> symbols;		// of the reader, shared by all chunks
+
+	vector<ReaderChunk> chunks;
+	unsigned int nextChunk;		// next chunk to parse
+	unsigned int currChunk;		// chunk being consumed
+	unsigned int currInst;
+	unsigned int maxAhead;
+	bool stop;
+
+	pthread_mutex_t chunkMutex;
+	pthread_cond_t parsedCond;
+	pthread_cond_t consumedCond;
+	vector<pthread_t> threadID;
+
+private:
+	void splitChunks(size_t size, int threadNum);
+	size_t skipBlock(size_t pos, size_t size);		// position after the block starting at pos
+	bool isGoldLine(size_t pos, size_t size);
+};
+
+} /* namespace segparser */
+#endif /* PARALLELREADER_H_ */
@@ -0,0 +1,137 @@
+/*
+ * TrainingCheckpoint.cpp
+ */
+
+#include "TrainingCheckpoint.h"
+#include "../util/Constant.h"
+#include "../util/SerializationUtils.h"
+#include <unistd.h>
+#include <iostream>
+
+namespace segparser {
+
+void* checkpointThreadFunc(void* instance);
+
+TrainingCheckpoint::TrainingCheckpoint() : iter(0), seed(0), dictKey(0), updateTimes(0), bestScore(0.0), isSaving(false) {
+}
+
+TrainingCheckpoint::~TrainingCheckpoint() {
+	waitSaving();
+}
+
+void* checkpointThreadFunc(void* instance) {
+	// ThrowException would exit the process under the learner, so a failure
+	// is only recorded here and reported by waitSaving
+	TrainingCheckpoint* ckpt = (TrainingCheckpoint*)instance;
+	ckpt->save(ckpt->saveFile);
+
+	pthread_exit(NULL);
+	return NULL;
+}
+
+bool TrainingCheckpoint::save(string file) {
+	// a crash while writing must not destroy the previous checkpoint
+	saveError.clear();
+	string tmpFile = file + ".tmp";
+	FILE *fs = fopen(tmpFile.c_str(), "wb");
+	if (!fs) {
+		saveError = "cannot open " + tmpFile;
+		return false;
+	}
+
+	bool ok = WriteInteger(fs, CHECKPOINT_FILE_MAGIC)
+			&& WriteInteger(fs, CHECKPOINT_FILE_VERSION)
+			&& WriteInteger(fs, iter)
+			&& WriteInteger(fs, seed)
+			&& WriteUINT64(fs, dictKey)
+			&& WriteInteger(fs, updateTimes)
+			&& WriteDouble(fs, bestScore)
+			&& WriteDoubleArray(fs, parameters)
+			&& WriteDoubleArray(fs, total)
+			&& WriteInteger(fs, predInfo.size());
+	for (unsigned int i = 0; ok && i < predInfo.size(); ++i) {
+		VariableInfo& info = predInfo[i];
+		ok = WriteIntegerArray(fs, info.segID)
+				&& WriteIntegerArray(fs, info.posID)
+				&& WriteInteger(fs, info.dep.size());
+		for (unsigned int j = 0; ok && j < info.dep.size(); ++j) {
+			ok = WriteInteger(fs, info.dep[j].hWord)
+					&& WriteInteger(fs, info.dep[j].hSeg);
+		}
+	}
+	ok = ok && fflush(fs) == 0 && fsync(fileno(fs)) == 0;
+	ok = (fclose(fs) == 0) && ok;
+
+	if (!ok) {
+		unlink(tmpFile.c_str());
+		saveError = "cannot write " + tmpFile;
+		return false;
+	}
+	if (rename(tmpFile.c_str(), file.c_str()) != 0) {
+		unlink(tmpFile.c_str());
+		saveError = "cannot replace " + file;
+		return false;
+	}
+	return true;
+}
+
+bool TrainingCheckpoint::load(string file) {
+	FILE *fs = fopen(file.c_str(), "rb");
+	if (!fs)
+		return false;
+
+	int magic = 0, version = 0;
+	CHECK(ReadInteger(fs, &magic));
+	CHECK(ReadInteger(fs, &version));
+	if (magic != CHECKPOINT_FILE_MAGIC || version != CHECKPOINT_FILE_VERSION)
+		ThrowException("not a training checkpoint: " + file);
+
+	CHECK(ReadInteger(fs, &iter));
+	CHECK(ReadInteger(fs, &seed));
+	CHECK(ReadUINT64(fs, &dictKey));
+	CHECK(ReadInteger(fs, &updateTimes));
+	CHECK(ReadDouble(fs, &bestScore));
+	CHECK(ReadDoubleArray(fs, &parameters));
+	CHECK(ReadDoubleArray(fs, &total));
+
+	int num = 0;
+	CHECK(ReadInteger(fs, &num));
+	predInfo.resize(num);
+	for (int i = 0; i < num; ++i) {
+		VariableInfo& info = predInfo[i];
+		CHECK(ReadIntegerArray(fs, &info.segID));
+		CHECK(ReadIntegerArray(fs, &info.posID));
+		int len = 0;
+		CHECK(ReadInteger(fs, &len));
+		info.dep.resize(len);
+		for (int j = 0; j < len; ++j) {
+			CHECK(ReadInteger(fs, &info.dep[j].hWord));
+			CHECK(ReadInteger(fs, &info.dep[j].hSeg));
+		}
+	}
+
+	fclose(fs);
+	return true;
+}
+
+void TrainingCheckpoint::startSaving(string file) {
+	saveFile = file;
+	isSaving = true;
+	int rc = pthread_create(&saveThread, NULL, checkpointThreadFunc, (void*)this);
+	if (rc) {
+		ThrowException("Error:unable to create checkpoint thread: " + to_string(rc));
+	}
+}
+
+void TrainingCheckpoint::waitSaving() {
+	if (isSaving) {
+		pthread_join(saveThread, NULL);
+		isSaving = false;
+
+		// the previous checkpoint is still in place, training goes on
+		if (!saveError.empty())
+			cout << "Warning: checkpoint not saved, " << saveError << endl;
+	}
+}
+
+} /* namespace segparser */
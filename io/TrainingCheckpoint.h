@@ -0,0 +1,50 @@
+/*
+ * TrainingCheckpoint.h
+ */
+
+#ifndef TRAININGCHECKPOINT_H_
+#define TRAININGCHECKPOINT_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+#include "../DependencyInstance.h"
+
+namespace segparser {
+
+using namespace std;
+
+// Everything the learner carries from one training iteration to the next.
+// Training continued from a checkpoint is identical to training that was
+// never interrupted: the samplers are seeded from the options for every
+// sentence, so the seed is the only random state.
+class TrainingCheckpoint {
+public:
+	TrainingCheckpoint();
+	virtual ~TrainingCheckpoint();
+
+	int iter;				// number of finished iterations
+	int seed;
+	uint64_t dictKey;		// the alphabets the weights belong to
+	int updateTimes;
+	double bestScore;		// of the dev runs finished before the checkpoint
+	vector<double> parameters;
+	vector<double> total;
+	vector<VariableInfo> predInfo;
+
+	bool save(string file);		// false with saveError set if it failed
+	bool load(string file);		// false if there is no checkpoint
+
+	// save a copy in the background, the learner can go on meanwhile
+	void startSaving(string file);
+	void waitSaving();
+
+	bool isSaving;
+	string saveFile;
+	string saveError;
+	pthread_t saveThread;
+};
+
+} /* namespace segparser */
+#endif /* TRAININGCHECKPOINT_H_ */
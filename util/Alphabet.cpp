@@ -57,6 +57,29 @@ void Alphabet::stopGrowth() {
 	growthStopped = true;
 }
 
+// hash of all (entry, index) pairs, used to check whether two alphabets
+// assign the same ids
+uint64_t Alphabet::fingerprint() {
+	vector<const string*> key(numEntries + 1, NULL);
+	for (auto& kv : map) {
+		if (kv.second >= 0 && kv.second <= numEntries)
+			key[kv.second] = &kv.first;
+	}
+
+	uint64_t h = 14695981039346656037ULL;		// FNV-1a
+	for (int i = 0; i <= numEntries; ++i) {
+		if (key[i]) {
+			for (unsigned int j = 0; j < key[i]->size(); ++j) {
+				h ^= (unsigned char)(*key[i])[j];
+				h *= 1099511628211ULL;
+			}
+		}
+		h ^= 0xff;			// entry separator, not a valid utf-8 byte
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
 void Alphabet::writeObject (FILE* fs) {
 	CHECK(WriteInteger(fs, numEntries));
 	CHECK(WriteStringIntegerMap(fs, map));
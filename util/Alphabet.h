@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <stdint.h>
 
 namespace segparser {
 
@@ -27,6 +28,7 @@ public:
 	void toArray(vector<string>& key);
 	int size();
 	void stopGrowth();
+	uint64_t fingerprint();
 
 	void writeObject (FILE* fs);
 	void readObject (FILE* fs);
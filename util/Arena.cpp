@@ -0,0 +1,65 @@
+/*
+ * Arena.cpp
+ */
+
+#include "Arena.h"
+#include "Constant.h"
+#include "StringUtils.h"
+#include <stdlib.h>
+#include <algorithm>
+
+namespace segparser {
+
+Arena::Arena() : curr(NULL), nextChunkSize(ARENA_MIN_CHUNK) {
+	pthread_mutex_init(&chunkMutex, NULL);
+}
+
+Arena::~Arena() {
+	for (unsigned int i = 0; i < chunks.size(); ++i) {
+		free(chunks[i]->data);
+		delete chunks[i];
+	}
+	pthread_mutex_destroy(&chunkMutex);
+}
+
+void* Arena::allocate(size_t size) {
+	size = (size + 15) & ~(size_t)15;
+
+	while (true) {
+		Chunk* c = __atomic_load_n(&curr, __ATOMIC_ACQUIRE);
+		if (c) {
+			size_t offset = __atomic_fetch_add(&c->used, size, __ATOMIC_RELAXED);
+			if (offset + size <= c->size)
+				return c->data + offset;
+		}
+
+		// full, the first thread that gets here adds a chunk
+		pthread_mutex_lock(&chunkMutex);
+		if (curr == c) {
+			Chunk* chunk = new Chunk();
+			chunk->size = max(nextChunkSize, size);
+			chunk->used = 0;
+			if (posix_memalign((void**)&chunk->data, 16, chunk->size) != 0) {
+				delete chunk;
+				pthread_mutex_unlock(&chunkMutex);
+				ThrowException("arena out of memory");
+			}
+			chunks.push_back(chunk);
+			nextChunkSize = min(nextChunkSize * 2, (size_t)ARENA_MAX_CHUNK);
+			__atomic_store_n(&curr, chunk, __ATOMIC_RELEASE);
+		}
+		pthread_mutex_unlock(&chunkMutex);
+	}
+	return NULL;
+}
+
+size_t Arena::allocatedSize() {
+	pthread_mutex_lock(&chunkMutex);
+	size_t size = 0;
+	for (unsigned int i = 0; i < chunks.size(); ++i)
+		size += chunks[i]->size;
+	pthread_mutex_unlock(&chunkMutex);
+	return size;
+}
+
+} /* namespace segparser */
@@ -0,0 +1,80 @@
+/*
+ * Arena.h
+ */
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <vector>
+#include <stddef.h>
+#include <pthread.h>
+
+namespace segparser {
+
+using namespace std;
+
+// Memory for many small objects that are all freed together when the
+// arena is destroyed. allocate is thread-safe and lock-free, except when
+// a new chunk is needed. Nothing is freed before that.
+class Arena {
+public:
+	Arena();
+	virtual ~Arena();
+
+	void* allocate(size_t size);		// 16-byte aligned
+	size_t allocatedSize();
+
+private:
+	struct Chunk {
+		char* data;
+		size_t size;
+		size_t used;			// may run past size when the chunk is full
+	};
+
+	Chunk* curr;
+	vector<Chunk*> chunks;
+	size_t nextChunkSize;
+	pthread_mutex_t chunkMutex;
+
+	Arena(const Arena&);
+	Arena& operator = (const Arena&);
+};
+
+// for containers and allocate_shared, deallocate does nothing
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	template <class U>
+	struct rebind {
+		typedef ArenaAllocator<U> other;
+	};
+
+	Arena* arena;
+
+	ArenaAllocator(Arena* arena) : arena(arena) {}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& a) : arena(a.arena) {}
+
+	T* allocate(size_t n) {
+		return (T*)arena->allocate(n * sizeof(T));
+	}
+
+	void deallocate(T* p, size_t n) {
+	}
+
+	template <class U>
+	bool operator == (const ArenaAllocator<U>& a) const {
+		return arena == a.arena;
+	}
+
+	template <class U>
+	bool operator != (const ArenaAllocator<U>& a) const {
+		return arena != a.arena;
+	}
+};
+
+} /* namespace segparser */
+#endif /* ARENA_H_ */
@@ -11,4 +11,6 @@ namespace segparser {
 
 const string PossibleLang::langString[] = {"qatar", "spmrl", "ctb"};
 
+const string ScoreKernel::kernelString[] = {"scalar", "avx2", "avx512"};
+
 } /* namespace segparser */
@@ -23,6 +23,33 @@ struct DecodingMode {
 	};
 };
 
+struct QuantMode {
+	enum types {
+		None = 0,
+		Float,
+		Int16,
+	};
+};
+
+struct SnapshotState {
+	enum types {
+		Pending = 0,
+		Busy,
+		Done,
+	};
+};
+
+struct ScoreKernel {
+	enum types {
+		Scalar = 0,
+		Avx2,
+		Avx512,
+		Count,
+	};
+
+	static const string kernelString[ScoreKernel::Count];
+};
+
 struct PossibleLang {
 	enum types {
 		Arabic = 0,
@@ -65,5 +92,27 @@ struct ConstLab {
 #define MAX_LEN_DIFF 4
 #define MAX_FEATURE_NUM 7
 
+#define COMPILED_CORPUS_MAGIC 0x50524f43		// "CORP"
+#define COMPILED_CORPUS_VERSION 1
+
+#define MODEL_FILE_MAGIC 0x4c444f4d			// "MODL"
+#define MODEL_FILE_VERSION 3
+
+#define CHECKPOINT_FILE_MAGIC 0x54504b43		// "CKPT"
+#define CHECKPOINT_FILE_VERSION 1
+
+#define WRITER_FLUSH_SIZE (1 << 20)			// bytes handed to the writer thread at once
+#define WRITER_FLUSH_INTERVAL 200				// ms, flush smaller blocks after this
+#define WRITER_MAX_PENDING (64 << 20)			// producers wait above this
+
+#define ARENA_MIN_CHUNK (4 << 10)			// bytes, the chunks double up to the max
+#define ARENA_MAX_CHUNK (1 << 20)
+
+#define REORDER_BUFFER_SIZE 256		// decoded sentences waiting for the output thread
+
+#define QUANT_BLOCK_BITS 8			// int16 weights share a scale in blocks of 2^QUANT_BLOCK_BITS
+
+#define SNAPSHOT_BLOCK_BITS 12		// dev snapshots are averaged in blocks of 2^SNAPSHOT_BLOCK_BITS weights
+
 } /* namespace segparser */
 #endif /* CONSTANT_H_ */
@@ -8,21 +8,28 @@
 #include "FeatureAlphabet.h"
 #include "SerializationUtils.h"
 #include "../FeatureEncoder.h"
+#include <stdlib.h>
+#include <limits.h>
+#include <algorithm>
 
 namespace segparser {
 
 FeatureAlphabet::FeatureAlphabet (int capacity) {
-	arcMap.reserve(capacity);
-	secondOrderMap.reserve(capacity);
-	thirdOrderMap.reserve(capacity);
-	highOrderMap.reserve(capacity);
 	numEntries = 0;
 	growthStopped = false;
+	hashBits = 0;
 
-	table[TemplateType::TArc] = &arcMap;
-	table[TemplateType::TSecondOrder] = &secondOrderMap;
-	table[TemplateType::TThirdOrder] = &thirdOrderMap;
-	table[TemplateType::THighOrder] = &highOrderMap;
+	// capacity is the expected number of features of all types
+	uint64_t cap = 2;
+	while (cap < (uint64_t)capacity / TemplateType::COUNT)
+		cap <<= 1;
+
+	for (int i = 0; i < TemplateType::COUNT; ++i) {
+		table[i] = NULL;
+		tableMask[i] = 0;
+		tableCount[i] = 0;
+		rehash(i, cap);
+	}
 }
 
 FeatureAlphabet::FeatureAlphabet() : FeatureAlphabet(10000) {
@@ -31,76 +38,267 @@ FeatureAlphabet::FeatureAlphabet() : FeatureAlphabet(10000) {
 FeatureAlphabet::~FeatureAlphabet() {
 }
 
-unordered_map<uint64_t, int>* FeatureAlphabet::getMap(int type) {
-
-	unordered_map<uint64_t, int>* intmap = NULL;
-	if (type < TemplateType::COUNT)
-		intmap = table[type];
-	else
-		ThrowException("undefined template type");
-	return intmap;
+uint64_t FeatureAlphabet::hashKey(uint64_t key) {
+	// the codes are packed bit fields, mix them before masking
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdULL;
+	key ^= key >> 33;
+	return key;
 }
 
 int FeatureAlphabet::lookupIndex(const int type, const uint64_t entry, bool addIfNotPresent) {
-	unordered_map<uint64_t, int>* intmap = getMap(type);
+	if (type >= TemplateType::COUNT)
+		ThrowException("undefined template type");
+	if (hashBits > 0)
+		return abs(hashIndex(type, entry));
 
-	int ret = 0;
-	if (intmap->find(entry) == intmap->end()) {
-		if (!growthStopped && addIfNotPresent) {
-			ret = numEntries + 1;
-			numEntries++;
-			(*intmap)[entry] = ret;
+	const FeatureTableEntry* t = table[type];
+	uint64_t mask = tableMask[type];
+	uint64_t pos = hashKey(entry) & mask;
+	while (t[pos].index != 0) {
+		if (t[pos].key == entry) {
+			if (!growthStopped)
+				featureCount[t[pos].index]++;
+			return t[pos].index;
 		}
+		pos = (pos + 1) & mask;
 	}
-	else {
-		ret = (*intmap)[entry];
-	}
-	return ret;
-}
 
-int FeatureAlphabet::lookupIndex(unordered_map<uint64_t, int>& intmap, const uint64_t entry, bool addIfNotPresent) {
 	int ret = 0;
-	if (intmap.find(entry) == intmap.end()) {
-		if (!growthStopped && addIfNotPresent) {
-			ret = numEntries + 1;
-			numEntries++;
-			intmap[entry] = ret;
-		}
-	}
-	else {
-		ret = intmap[entry];
+	if (!growthStopped && addIfNotPresent) {
+		ret = numEntries + 1;
+		numEntries++;
+		insert(type, entry, ret);
+		featureCount.resize(numEntries + 1);
+		featureCount[ret] = 1;
 	}
 	return ret;
 }
 
+void FeatureAlphabet::useHashKernel(int bits) {
+	if (bits <= 0 || bits > 30)
+		ThrowException("hash kernel bits should be between 1 and 30");
+	hashBits = bits;
+	numEntries = 1 << bits;
+	growthStopped = true;
+}
+
+bool FeatureAlphabet::isHashed() {
+	return hashBits > 0;
+}
+
+int FeatureAlphabet::hashIndex(int type, uint64_t code) {
+	uint64_t h = hashKey(code ^ ((uint64_t)(type + 1) * 0x9e3779b97f4a7c15ULL));
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	// index 0 is not a feature, the highest bit gives the sign
+	int index = (int)(h & ((1ULL << hashBits) - 1)) + 1;
+	return (h >> 63) ? -index : index;
+}
+
 int FeatureAlphabet::lookupIndex(const int type, const uint64_t entry) {
 	return lookupIndex (type, entry, true);
 }
 
+void FeatureAlphabet::insert(int type, uint64_t key, int index) {
+	// the key is not in the table
+	if (2 * (uint64_t)(tableCount[type] + 1) > tableMask[type] + 1)
+		rehash(type, 2 * (tableMask[type] + 1));
+
+	uint64_t mask = tableMask[type];
+	uint64_t pos = hashKey(key) & mask;
+	while (storage[type][pos].index != 0)
+		pos = (pos + 1) & mask;
+	storage[type][pos].key = key;
+	storage[type][pos].index = index;
+	tableCount[type]++;
+}
+
+void FeatureAlphabet::rehash(int type, uint64_t capacity) {
+	vector<FeatureTableEntry> old;
+	old.swap(storage[type]);
+
+	FeatureTableEntry empty;
+	empty.key = 0;
+	empty.index = 0;
+	empty.pad = 0;
+	storage[type].assign(capacity, empty);
+
+	uint64_t mask = capacity - 1;
+	for (unsigned int i = 0; i < old.size(); ++i) {
+		if (old[i].index == 0)
+			continue;
+		uint64_t pos = hashKey(old[i].key) & mask;
+		while (storage[type][pos].index != 0)
+			pos = (pos + 1) & mask;
+		storage[type][pos] = old[i];
+	}
+
+	table[type] = &storage[type][0];
+	tableMask[type] = mask;
+}
+
 int FeatureAlphabet::size() {
 	return numEntries + 1;
 }
 
+int FeatureAlphabet::tableSize(int type) {
+	return tableCount[type];
+}
+
 void FeatureAlphabet::stopGrowth() {
 	growthStopped = true;
+	vector<int>().swap(featureCount);
+
+	// shrink tables that were allocated larger than needed
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		if (storage[type].empty())
+			continue;		// mapped
+		uint64_t cap = 2;
+		while (cap < 2 * (uint64_t)tableCount[type])
+			cap <<= 1;
+		if (cap < tableMask[type] + 1)
+			rehash(type, cap);
+	}
+}
+
+void FeatureAlphabet::toArray(int type, vector<uint64_t>& keys, vector<int>& index) {
+	keys.clear();
+	index.clear();
+	for (uint64_t i = 0; i <= tableMask[type]; ++i) {
+		if (table[type][i].index != 0) {
+			keys.push_back(table[type][i].key);
+			index.push_back(table[type][i].index);
+		}
+	}
 }
 
-void FeatureAlphabet::writeObject (FILE* fs) {
-	CHECK(WriteInteger(fs, numEntries));
-	CHECK(WriteUINT64IntegerMap(fs, arcMap));
-	CHECK(WriteUINT64IntegerMap(fs, secondOrderMap));
-	CHECK(WriteUINT64IntegerMap(fs, thirdOrderMap));
-	CHECK(WriteUINT64IntegerMap(fs, highOrderMap));
-	CHECK(WriteBool(fs, growthStopped));
+int FeatureAlphabet::removeRare(int cutoff) {
+	if (growthStopped || hashBits > 0)
+		return 0;
+
+	// the kept features stay in the order they were seen
+	vector<int> newIndex(numEntries + 1, 0);
+	int num = 0;
+	for (int i = 1; i <= numEntries; ++i) {
+		if (featureCount[i] >= cutoff)
+			newIndex[i] = ++num;
+	}
+	int removed = numEntries - num;
+	if (removed > 0)
+		renumber(this, newIndex);
+	featureCount.assign(numEntries + 1, cutoff);		// all kept features reached the cutoff
+	return removed;
+}
+
+void FeatureAlphabet::renumber(FeatureAlphabet* src, const vector<int>& newIndex) {
+	vector<uint64_t> keys[TemplateType::COUNT];
+	vector<int> index[TemplateType::COUNT];
+	for (int type = 0; type < TemplateType::COUNT; ++type)
+		src->toArray(type, keys[type], index[type]);
+
+	numEntries = 0;
+	hashBits = 0;
+	growthStopped = src->growthStopped;
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		int num = 0;
+		for (unsigned int i = 0; i < index[type].size(); ++i)
+			if (newIndex[index[type][i]] > 0)
+				num++;
+
+		uint64_t cap = 2;
+		while (cap < 2 * (uint64_t)num)
+			cap <<= 1;
+		tableCount[type] = 0;
+		storage[type].clear();
+		rehash(type, cap);
+		for (unsigned int i = 0; i < index[type].size(); ++i) {
+			int id = newIndex[index[type][i]];
+			if (id > 0) {
+				insert(type, keys[type][i], id);
+				numEntries = max(numEntries, id);
+			}
+		}
+	}
 }
 
 void FeatureAlphabet::readObject (FILE* fs) {
+	// format of models saved before writeTable
+	hashBits = 0;
 	CHECK(ReadInteger(fs, &numEntries));
-	CHECK(ReadUINT64IntegerMap(fs, &arcMap));
-	CHECK(ReadUINT64IntegerMap(fs, &secondOrderMap));
-	CHECK(ReadUINT64IntegerMap(fs, &thirdOrderMap));
-	CHECK(ReadUINT64IntegerMap(fs, &highOrderMap));
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		unordered_map<uint64_t, int> intmap;
+		CHECK(ReadUINT64IntegerMap(fs, &intmap));
+
+		tableCount[type] = 0;
+		uint64_t cap = 2;
+		while (cap < 2 * intmap.size())
+			cap <<= 1;
+		storage[type].clear();
+		rehash(type, cap);
+		for (auto kv : intmap)
+			insert(type, kv.first, kv.second);
+	}
 	CHECK(ReadBool(fs, &growthStopped));
 }
 
+void FeatureAlphabet::writeTable(FILE* fs) {
+	// number of features, hash kernel bits, then for each type: capacity,
+	// number of entries and the slots. all fields are 8-byte aligned for mapping
+	CHECK(WriteUINT64(fs, numEntries));
+	CHECK(WriteUINT64(fs, hashBits));
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		uint64_t cap = tableMask[type] + 1;
+		CHECK(WriteUINT64(fs, cap));
+		CHECK(WriteUINT64(fs, tableCount[type]));
+		CHECK((fwrite(table[type], sizeof(FeatureTableEntry), cap, fs) == cap));
+	}
+}
+
+const char* FeatureAlphabet::mapTable(const char* data, const char* end) {
+	// the fields are checked against the end of the mapping before they are
+	// read, so that a truncated or corrupted file cannot be read past its end
+	if (end - data < (ptrdiff_t)(2 * sizeof(uint64_t)))
+		return NULL;
+	uint64_t entries = *(const uint64_t*)data;
+	uint64_t bits = *(const uint64_t*)(data + sizeof(uint64_t));
+	if (entries > (uint64_t)INT_MAX || bits > 30)
+		return NULL;
+	data += 2 * sizeof(uint64_t);
+
+	const FeatureTableEntry* mapped[TemplateType::COUNT];
+	uint64_t mask[TemplateType::COUNT];
+	int count[TemplateType::COUNT];
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		if (end - data < (ptrdiff_t)(2 * sizeof(uint64_t)))
+			return NULL;
+		uint64_t cap = *(const uint64_t*)data;
+		uint64_t num = *(const uint64_t*)(data + sizeof(uint64_t));
+		data += 2 * sizeof(uint64_t);
+
+		// probing needs a power of two capacity and at least one empty slot
+		if (cap == 0 || (cap & (cap - 1)) != 0 || num >= cap)
+			return NULL;
+		if (cap > (uint64_t)(end - data) / sizeof(FeatureTableEntry))
+			return NULL;
+
+		mapped[type] = (const FeatureTableEntry*)data;
+		mask[type] = cap - 1;
+		count[type] = num;
+		data += cap * sizeof(FeatureTableEntry);
+	}
+
+	numEntries = entries;
+	hashBits = bits;
+	growthStopped = true;
+	for (int type = 0; type < TemplateType::COUNT; ++type) {
+		vector<FeatureTableEntry>().swap(storage[type]);
+		table[type] = mapped[type];
+		tableMask[type] = mask[type];
+		tableCount[type] = count[type];
+	}
+	return data;
+}
+
 } /* namespace segparser */
@@ -8,41 +8,75 @@
 #ifndef FEATUREALPHABET_H_
 #define FEATUREALPHABET_H_
 
-#include <unordered_map>
 #include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
 #include "../FeatureEncoder.h"
 
 namespace segparser {
 
 using namespace std;
 
+// one slot of the flat lookup tables, also the layout in the model file
+struct FeatureTableEntry {
+	uint64_t key;
+	int index;			// 0 for an empty slot
+	int pad;
+};
+
 class FeatureAlphabet {
 public:
 	FeatureAlphabet(int capacity);
 	FeatureAlphabet();
 	virtual ~FeatureAlphabet();
 
-	int lookupIndex (const string& entry, bool addIfNotPresent);
-	int lookupIndex (const string& entry);
-	unordered_map<uint64_t, int>* getMap(int type);
 	int lookupIndex(const int type, const uint64_t entry, bool addIfNotPresent);
-	int lookupIndex(unordered_map<uint64_t, int>& intmap, const uint64_t entry, bool addIfNotPresent);
 	int lookupIndex(const int type, const uint64_t entry);
 	int size();
 	void stopGrowth();
-	void writeObject (FILE* fs);
 	void readObject (FILE* fs);
+	void toArray(int type, vector<uint64_t>& keys, vector<int>& index);
+
+	// features are counted while the alphabet grows. removeRare drops the
+	// ones seen less than cutoff times, and returns how many were dropped
+	int removeRare(int cutoff);
+
+	// take the features of src with a positive newIndex[index], under
+	// that index. src may be this alphabet
+	void renumber(FeatureAlphabet* src, const vector<int>& newIndex);
 
-	unordered_map<uint64_t, int> arcMap;
-	unordered_map<uint64_t, int> secondOrderMap;
-	unordered_map<uint64_t, int> thirdOrderMap;
-	unordered_map<uint64_t, int> highOrderMap;
+	// the tables are stored as they are, and can be used directly from a mapped
+	// file. mapTable returns the end of the tables, or NULL if they do not fit
+	// before end or are not valid
+	void writeTable(FILE* fs);
+	const char* mapTable(const char* data, const char* end);
+	int tableSize(int type);
+
+	// hash kernel: the codes are hashed into a fixed number of features and
+	// nothing is stored. hashIndex is negative for features that are
+	// subtracted (signed hash)
+	void useHashKernel(int bits);
+	bool isHashed();
+	int hashIndex(int type, uint64_t code);
 
 private:
 	int numEntries;
 	bool growthStopped;
+	int hashBits;			// 0 unless the hash kernel is used
+
+	// one open-addressing table per template type, with a load factor of
+	// at most 0.5. the slots are in storage, or in a mapped model file
+	const FeatureTableEntry* table[TemplateType::COUNT];
+	uint64_t tableMask[TemplateType::COUNT];
+	int tableCount[TemplateType::COUNT];
+	vector<FeatureTableEntry> storage[TemplateType::COUNT];
+
+	vector<int> featureCount;		// occurrences of each index, only while growing
 
-	unordered_map<uint64_t, int>* table[TemplateType::COUNT];
+	static uint64_t hashKey(uint64_t key);
+	void insert(int type, uint64_t key, int index);
+	void rehash(int type, uint64_t capacity);
 };
 
 } /* namespace segparser */
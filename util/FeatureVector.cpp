@@ -8,12 +8,10 @@
 #include "FeatureVector.h"
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
 
 namespace segparser {
 
-vector<double> FeatureVector::dpVec;
-unsigned int FeatureVector::rows;
-
 FeatureVector::FeatureVector() {
 }
 
@@ -53,6 +51,13 @@ void FeatureVector::concat(FeatureVector* fv) {
 	}
 }
 
+void FeatureVector::concat(PackedFeatureVector* fv) {
+	binaryIndex.insert(binaryIndex.end(), fv->binaryIndex, fv->binaryIndex + fv->binaryNum);
+	negBinaryIndex.insert(negBinaryIndex.end(), fv->negBinaryIndex, fv->negBinaryIndex + fv->negBinaryNum);
+	normalIndex.insert(normalIndex.end(), fv->normalIndex, fv->normalIndex + fv->normalNum);
+	normalValue.insert(normalValue.end(), fv->normalValue, fv->normalValue + fv->normalNum);
+}
+
 void FeatureVector::concatNeg(FeatureVector* fv) {
 	for(unsigned int i = 0; i < fv->binaryIndex.size(); ++i) {
 		negBinaryIndex.push_back(fv->binaryIndex[i]);
@@ -66,64 +71,44 @@ void FeatureVector::concatNeg(FeatureVector* fv) {
 	}
 }
 
-double FeatureVector::dotProduct(FeatureVector* fv) {
-	double result = 0.0;
+static bool indexLess(const pair<int, double>& a, const pair<int, double>& b) {
+	return a.first < b.first;
+}
 
+void FeatureVector::mergeEntries(vector<pair<int, double> >& coef) {
 	double b = 2.0;
 
+	// the entries of an index are added in the order of the lists, as
+	// they would be in a dense array
+	coef.clear();
+	coef.reserve(binaryIndex.size() + negBinaryIndex.size() + normalIndex.size());
 	for(unsigned int i = 0; i < binaryIndex.size(); ++i) {
-		dpVec[binaryIndex[i]] += 1.0;
-	}
-	for(unsigned int i = 0; i < negBinaryIndex.size(); ++i) {
-		dpVec[negBinaryIndex[i]] -= 1.0;
-	}
-	for(unsigned int i = 0; i < normalIndex.size(); ++i) {
-		double val = min(b, max(-b, normalValue[i]));
-		dpVec[normalIndex[i]] += val;
-	}
-
-	for(unsigned int i = 0; i < fv->binaryIndex.size(); ++i) {
-		result += dpVec[fv->binaryIndex[i]];
-	}
-	for(unsigned int i = 0; i < fv->negBinaryIndex.size(); ++i) {
-		result -= dpVec[fv->negBinaryIndex[i]];
-	}
-	for(unsigned int i = 0; i < fv->normalIndex.size(); ++i) {
-		double val = min(b, max(-b, fv->normalValue[i]));
-		result += dpVec[fv->normalIndex[i]] * val;
-	}
-
-	for(unsigned int i = 0; i < binaryIndex.size(); ++i) {
-		dpVec[binaryIndex[i]] = 0.0;
+		coef.push_back(make_pair(binaryIndex[i], 1.0));
 	}
 	for(unsigned int i = 0; i < negBinaryIndex.size(); ++i) {
-		dpVec[negBinaryIndex[i]] = 0.0;
+		coef.push_back(make_pair(negBinaryIndex[i], -1.0));
 	}
 	for(unsigned int i = 0; i < normalIndex.size(); ++i) {
-		dpVec[normalIndex[i]] = 0.0;
-	}
-
-	return result;
-}
-
-double FeatureVector::dotProduct(vector<double>& param) {
-	// get score
-	double score = 0.0;
-	for(unsigned int i = 0; i < binaryIndex.size(); ++i) {
-		score += param[binaryIndex[i]];
-	}
-	for(unsigned int i = 0; i < negBinaryIndex.size(); ++i) {
-		score -= param[negBinaryIndex[i]];
-	}
-	for(unsigned int i = 0; i < normalIndex.size(); ++i) {
-		score += param[normalIndex[i]] * normalValue[i];
-	}
-	return score;
-}
-
-void FeatureVector::initVec(unsigned int _rows) {
-	rows = _rows;
-	dpVec.resize(rows);
+		coef.push_back(make_pair(normalIndex[i], min(b, max(-b, normalValue[i]))));
+	}
+	stable_sort(coef.begin(), coef.end(), indexLess);
+
+	unsigned int num = 0;
+	for(unsigned int i = 0; i < coef.size(); ++i) {
+		if (num > 0 && coef[num - 1].first == coef[i].first) {
+			coef[num - 1].second += coef[i].second;
+		}
+		else {
+			if (num > 0 && coef[num - 1].second == 0.0)
+				num--;		// cancelled out
+			coef[num].first = coef[i].first;
+			coef[num].second = coef[i].second;
+			num++;
+		}
+	}
+	if (num > 0 && coef[num - 1].second == 0.0)
+		num--;
+	coef.resize(num);
 }
 
 void FeatureVector::output() {
@@ -147,4 +132,27 @@ void FeatureVector::output() {
 	cin >> x;
 }
 
+PackedFeatureVector::PackedFeatureVector() : binaryIndex(NULL), negBinaryIndex(NULL), normalIndex(NULL), normalValue(NULL),
+		binaryNum(0), negBinaryNum(0), normalNum(0) {
+}
+
+template <class T>
+static const T* copyToArena(const vector<T>& v, Arena* arena) {
+	if (v.empty())
+		return NULL;
+	T* p = (T*)arena->allocate(v.size() * sizeof(T));
+	copy(v.begin(), v.end(), p);
+	return p;
+}
+
+void PackedFeatureVector::pack(FeatureVector* fv, Arena* arena) {
+	binaryIndex = copyToArena(fv->binaryIndex, arena);
+	negBinaryIndex = copyToArena(fv->negBinaryIndex, arena);
+	normalIndex = copyToArena(fv->normalIndex, arena);
+	normalValue = copyToArena(fv->normalValue, arena);
+	binaryNum = fv->binaryIndex.size();
+	negBinaryNum = fv->negBinaryIndex.size();
+	normalNum = fv->normalIndex.size();
+}
+
 } /* namespace segparser */
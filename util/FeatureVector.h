@@ -9,11 +9,31 @@
 #define FEATUREVECTOR_H_
 
 #include <vector>
+#include "Arena.h"
 
 namespace segparser {
 
 using namespace std;
 
+class FeatureVector;
+
+// a feature vector in memory of an Arena, used by the cache tables.
+// it is written once by pack and only read afterwards
+class PackedFeatureVector {
+public:
+	const int* binaryIndex;
+	const int* negBinaryIndex;
+	const int* normalIndex;
+	const double* normalValue;
+	int binaryNum;
+	int negBinaryNum;
+	int normalNum;
+
+	PackedFeatureVector();
+
+	void pack(FeatureVector* fv, Arena* arena);
+};
+
 class FeatureVector {
 public:
 	vector<int> binaryIndex;
@@ -29,15 +49,15 @@ public:
 	void addBinary(int index);
 	void addNegBinary(int index);
 	void concat(FeatureVector* fv);
+	void concat(PackedFeatureVector* fv);
 	void concatNeg(FeatureVector* fv);
-	double dotProduct(FeatureVector* fv);
-	double dotProduct(vector<double>& param);
 
-	static void initVec(unsigned int _rows);
+	// the coefficient of every index, sorted by index. repeated entries are
+	// added up, entries that cancel out are removed, and valued entries are
+	// clipped to [-2, 2] first, as in the updates
+	void mergeEntries(vector<pair<int, double> >& coef);
+
 	void output();
-private:
-	static vector<double> dpVec;
-	static unsigned int rows;
 };
 
 } /* namespace segparser */
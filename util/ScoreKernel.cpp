@@ -0,0 +1,213 @@
+/*
+ * ScoreKernel.cpp
+ */
+
+#include "ScoreKernel.h"
+#include "Constant.h"
+#include <immintrin.h>
+
+namespace segparser {
+
+double scalarGatherAdd(double score, const double* w, const int* index, int n) {
+	for (int i = 0; i < n; ++i)
+		score += w[index[i]];
+	return score;
+}
+
+double scalarGatherSub(double score, const double* w, const int* index, int n) {
+	for (int i = 0; i < n; ++i)
+		score -= w[index[i]];
+	return score;
+}
+
+double scalarGatherDot(double score, const double* w, const int* index, const double* val, int n) {
+	for (int i = 0; i < n; ++i)
+		score += w[index[i]] * val[i];
+	return score;
+}
+
+// the vector kernels are compiled for their instruction set only, and
+// are only called after the cpu check in setScoreKernel. the gathers use
+// the masked forms with a zero source, the plain ones read an
+// uninitialized register
+
+__attribute__((target("avx2")))
+static inline __m256d avx2Gather(const double* w, __m128i id) {
+	__m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	return _mm256_mask_i32gather_pd(_mm256_setzero_pd(), w, id, all, 8);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d avx512Gather(const double* w, __m256i id) {
+	return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, id, w, 8);
+}
+
+// same order as _mm512_reduce_add_pd. its half extracts, like the cast,
+// have an undefined source as well
+__attribute__((target("avx512f")))
+static inline double avx512Reduce(__m512d v) {
+	__m256d hi = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 1);
+	__m256d lo = _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 0);
+	__m256d t = _mm256_add_pd(hi, lo);
+	__m128d s = _mm_add_pd(_mm256_extractf128_pd(t, 1), _mm256_castpd256_pd128(t));
+	s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+	return _mm_cvtsd_f64(s);
+}
+
+__attribute__((target("avx2")))
+static double avx2Sum(const double* w, const int* index, int n, int& i) {
+	// two accumulators to hide the gather latency
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i id0 = _mm_loadu_si128((const __m128i*)(index + i));
+		__m128i id1 = _mm_loadu_si128((const __m128i*)(index + i + 4));
+		acc0 = _mm256_add_pd(acc0, avx2Gather(w, id0));
+		acc1 = _mm256_add_pd(acc1, avx2Gather(w, id1));
+	}
+	if (i + 4 <= n) {
+		__m128i id0 = _mm_loadu_si128((const __m128i*)(index + i));
+		acc0 = _mm256_add_pd(acc0, avx2Gather(w, id0));
+		i += 4;
+	}
+	acc0 = _mm256_add_pd(acc0, acc1);
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+	s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+	return _mm_cvtsd_f64(s);
+}
+
+__attribute__((target("avx2")))
+static double avx2Add(double score, const double* w, const int* index, int n) {
+	int i = 0;
+	double sum = avx2Sum(w, index, n, i);
+	for (; i < n; ++i)
+		sum += w[index[i]];
+	return score + sum;
+}
+
+__attribute__((target("avx2")))
+static double avx2Sub(double score, const double* w, const int* index, int n) {
+	int i = 0;
+	double sum = avx2Sum(w, index, n, i);
+	for (; i < n; ++i)
+		sum += w[index[i]];
+	return score - sum;
+}
+
+__attribute__((target("avx2")))
+static double avx2Dot(double score, const double* w, const int* index, const double* val, int n) {
+	__m256d acc0 = _mm256_setzero_pd();
+	__m256d acc1 = _mm256_setzero_pd();
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128i id0 = _mm_loadu_si128((const __m128i*)(index + i));
+		__m128i id1 = _mm_loadu_si128((const __m128i*)(index + i + 4));
+		acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(avx2Gather(w, id0), _mm256_loadu_pd(val + i)));
+		acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(avx2Gather(w, id1), _mm256_loadu_pd(val + i + 4)));
+	}
+	acc0 = _mm256_add_pd(acc0, acc1);
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+	s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+	double sum = _mm_cvtsd_f64(s);
+	for (; i < n; ++i)
+		sum += w[index[i]] * val[i];
+	return score + sum;
+}
+
+__attribute__((target("avx512f")))
+static double avx512Sum(const double* w, const int* index, int n, int& i) {
+	__m512d acc0 = _mm512_setzero_pd();
+	__m512d acc1 = _mm512_setzero_pd();
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m256i id0 = _mm256_loadu_si256((const __m256i*)(index + i));
+		__m256i id1 = _mm256_loadu_si256((const __m256i*)(index + i + 8));
+		acc0 = _mm512_add_pd(acc0, avx512Gather(w, id0));
+		acc1 = _mm512_add_pd(acc1, avx512Gather(w, id1));
+	}
+	if (i + 8 <= n) {
+		__m256i id0 = _mm256_loadu_si256((const __m256i*)(index + i));
+		acc0 = _mm512_add_pd(acc0, avx512Gather(w, id0));
+		i += 8;
+	}
+	return avx512Reduce(_mm512_add_pd(acc0, acc1));
+}
+
+__attribute__((target("avx512f")))
+static double avx512Add(double score, const double* w, const int* index, int n) {
+	int i = 0;
+	double sum = avx512Sum(w, index, n, i);
+	for (; i < n; ++i)
+		sum += w[index[i]];
+	return score + sum;
+}
+
+__attribute__((target("avx512f")))
+static double avx512Sub(double score, const double* w, const int* index, int n) {
+	int i = 0;
+	double sum = avx512Sum(w, index, n, i);
+	for (; i < n; ++i)
+		sum += w[index[i]];
+	return score - sum;
+}
+
+__attribute__((target("avx512f")))
+static double avx512Dot(double score, const double* w, const int* index, const double* val, int n) {
+	__m512d acc = _mm512_setzero_pd();
+	int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i id = _mm256_loadu_si256((const __m256i*)(index + i));
+		acc = _mm512_add_pd(acc, _mm512_mul_pd(avx512Gather(w, id), _mm512_loadu_pd(val + i)));
+	}
+	double sum = avx512Reduce(acc);
+	for (; i < n; ++i)
+		sum += w[index[i]] * val[i];
+	return score + sum;
+}
+
+GatherAddFunc gatherAdd = scalarGatherAdd;
+GatherAddFunc gatherSub = scalarGatherSub;
+GatherDotFunc gatherDot = scalarGatherDot;
+
+static int currKernel = ScoreKernel::Scalar;
+
+bool setScoreKernel(int kernel) {
+	__builtin_cpu_init();
+	if (kernel == ScoreKernel::Avx512) {
+		if (!__builtin_cpu_supports("avx512f"))
+			return false;
+		gatherAdd = avx512Add;
+		gatherSub = avx512Sub;
+		gatherDot = avx512Dot;
+	}
+	else if (kernel == ScoreKernel::Avx2) {
+		if (!__builtin_cpu_supports("avx2"))
+			return false;
+		gatherAdd = avx2Add;
+		gatherSub = avx2Sub;
+		gatherDot = avx2Dot;
+	}
+	else {
+		gatherAdd = scalarGatherAdd;
+		gatherSub = scalarGatherSub;
+		gatherDot = scalarGatherDot;
+	}
+	currKernel = kernel;
+	return true;
+}
+
+int getScoreKernel() {
+	return currKernel;
+}
+
+int selectScoreKernel(bool useSimd) {
+	if (useSimd) {
+		if (setScoreKernel(ScoreKernel::Avx512))
+			return currKernel;
+		if (setScoreKernel(ScoreKernel::Avx2))
+			return currKernel;
+	}
+	setScoreKernel(ScoreKernel::Scalar);
+	return currKernel;
+}
+
+} /* namespace segparser */
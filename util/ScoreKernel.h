@@ -0,0 +1,36 @@
+/*
+ * ScoreKernel.h
+ */
+
+#ifndef SCOREKERNEL_H_
+#define SCOREKERNEL_H_
+
+namespace segparser {
+
+// The inner loop of Parameters::getScore:
+// weights gathered by feature index, added to (or subtracted from) score.
+// The scalar kernels add in index order, exactly like a plain loop. The
+// SIMD kernels gather several weights at once, so their sums may differ
+// in the last bits.
+typedef double (*GatherAddFunc)(double score, const double* w, const int* index, int n);
+typedef double (*GatherDotFunc)(double score, const double* w, const int* index, const double* val, int n);
+
+extern GatherAddFunc gatherAdd;		// score + sum w[index[i]]
+extern GatherAddFunc gatherSub;		// score - sum w[index[i]]
+extern GatherDotFunc gatherDot;		// score + sum w[index[i]] * val[i]
+
+// the scalar kernels on every cpu, for scores that must not depend on
+// the machine
+double scalarGatherAdd(double score, const double* w, const int* index, int n);
+double scalarGatherSub(double score, const double* w, const int* index, int n);
+double scalarGatherDot(double score, const double* w, const int* index, const double* val, int n);
+
+// ScoreKernel type, false if the cpu does not support it
+bool setScoreKernel(int kernel);
+int getScoreKernel();
+
+// the fastest kernel of the cpu, or scalar if useSimd is false
+int selectScoreKernel(bool useSimd);
+
+} /* namespace segparser */
+#endif /* SCOREKERNEL_H_ */
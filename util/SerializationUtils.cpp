@@ -70,6 +70,24 @@ bool WriteDoubleArray(FILE *fs, const std::vector<double>& arr) {
 	return true;
 }
 
+bool WriteIntegerArray(FILE *fs, const std::vector<int>& arr) {
+	if (1 != WriteInteger(fs, arr.size()))
+		return false;
+	if (arr.size() > 0 && arr.size() != fwrite(&arr[0], sizeof(int), arr.size(), fs))
+		return false;
+	return true;
+}
+
+bool WriteStringArray(FILE *fs, const std::vector<std::string>& arr) {
+	if (1 != WriteInteger(fs, arr.size()))
+		return false;
+	for (unsigned int i = 0; i < arr.size(); ++i) {
+		if (1 != WriteString(fs, arr[i]))
+			return false;
+	}
+	return true;
+}
+
 bool ReadString(FILE *fs, std::string *data) {
 	unsigned int length;
 	if (1 != fread(&length, sizeof(int), 1, fs)) return false;
@@ -149,3 +167,25 @@ bool ReadDoubleArray(FILE* fs, std::vector<double>* arr) {
 }
 
 
+
+bool ReadIntegerArray(FILE* fs, std::vector<int>* arr) {
+	int size = 0;
+	if (1 != ReadInteger(fs, &size))
+		return false;
+	arr->resize(size);
+	if (size > 0 && (size_t)size != fread(&(*arr)[0], sizeof(int), size, fs))
+		return false;
+	return true;
+}
+
+bool ReadStringArray(FILE* fs, std::vector<std::string>* arr) {
+	int size = 0;
+	if (1 != ReadInteger(fs, &size))
+		return false;
+	arr->resize(size);
+	for (int i = 0; i < size; ++i) {
+		if (1 != ReadString(fs, &(*arr)[i]))
+			return false;
+	}
+	return true;
+}
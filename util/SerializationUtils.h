@@ -23,6 +23,8 @@ extern bool WriteDouble(FILE *fs, double value);
 extern bool WriteStringIntegerMap(FILE *fs, const std::unordered_map<std::string, int>& map);
 extern bool WriteUINT64IntegerMap(FILE *fs, const std::unordered_map<uint64_t, int>& map);
 extern bool WriteDoubleArray(FILE *fs, const std::vector<double>& arr);
+extern bool WriteIntegerArray(FILE *fs, const std::vector<int>& arr);
+extern bool WriteStringArray(FILE *fs, const std::vector<std::string>& arr);
 
 extern bool ReadString(FILE *fs, std::string *data);
 extern bool ReadBool(FILE *fs, bool *value);
@@ -32,6 +34,8 @@ extern bool ReadDouble(FILE *fs, double *value);
 extern bool ReadStringIntegerMap(FILE *fs, std::unordered_map<std::string, int>* map);
 extern bool ReadUINT64IntegerMap(FILE *fs, std::unordered_map<uint64_t, int>* map);
 extern bool ReadDoubleArray(FILE *fs, std::vector<double>* arr);
+extern bool ReadIntegerArray(FILE *fs, std::vector<int>* arr);
+extern bool ReadStringArray(FILE *fs, std::vector<std::string>* arr);
 
 #define CHECK(x) { if (!x) ThrowException("check bug"); }
 
@@ -0,0 +1,102 @@
+/*
+ * StringPiece.h
+ */
+
+#ifndef STRINGPIECE_H_
+#define STRINGPIECE_H_
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+// A non-owning reference to a range of characters (e.g. a line in a memory
+// mapped file). The referenced buffer must outlive the piece.
+class StringPiece {
+public:
+	static const size_t npos = string::npos;
+
+	StringPiece() : ptr(NULL), len(0) {}
+	StringPiece(const char* _ptr, size_t _len) : ptr(_ptr), len(_len) {}
+	StringPiece(const char* str) : ptr(str), len(strlen(str)) {}
+	StringPiece(const string& str) : ptr(str.data()), len(str.size()) {}
+
+	const char* data() const { return ptr; }
+	size_t size() const { return len; }
+	size_t length() const { return len; }
+	bool empty() const { return len == 0; }
+	char operator[] (size_t i) const { return ptr[i]; }
+
+	string toString() const {
+		return string(ptr, len);
+	}
+
+	StringPiece substr(size_t pos, size_t n = npos) const {
+		if (pos > len)
+			pos = len;
+		if (n > len - pos)
+			n = len - pos;
+		return StringPiece(ptr + pos, n);
+	}
+
+	size_t find(char c, size_t pos = 0) const {
+		for (size_t i = pos; i < len; ++i)
+			if (ptr[i] == c)
+				return i;
+		return npos;
+	}
+
+	size_t find(const StringPiece& s, size_t pos = 0) const {
+		if (s.len == 0)
+			return pos <= len ? pos : npos;
+		if (s.len > len)
+			return npos;
+		for (size_t i = pos; i + s.len <= len; ++i)
+			if (ptr[i] == s.ptr[0] && memcmp(ptr + i, s.ptr, s.len) == 0)
+				return i;
+		return npos;
+	}
+
+	size_t rfind(char c) const {
+		for (size_t i = len; i > 0; --i)
+			if (ptr[i - 1] == c)
+				return i - 1;
+		return npos;
+	}
+
+	bool operator == (const StringPiece& s) const {
+		return len == s.len && (len == 0 || memcmp(ptr, s.ptr, len) == 0);
+	}
+
+	bool operator != (const StringPiece& s) const {
+		return !(*this == s);
+	}
+
+	// same semantics as atoi/atof on the referenced characters
+	int toInt() const {
+		char buf[64];
+		if (len < sizeof(buf)) {
+			memcpy(buf, ptr, len);
+			buf[len] = '\0';
+			return atoi(buf);
+		}
+		return atoi(toString().c_str());
+	}
+
+	double toDouble() const {
+		char buf[64];
+		if (len < sizeof(buf)) {
+			memcpy(buf, ptr, len);
+			buf[len] = '\0';
+			return atof(buf);
+		}
+		return atof(toString().c_str());
+	}
+
+private:
+	const char* ptr;
+	size_t len;
+};
+
+#endif /* STRINGPIECE_H_ */
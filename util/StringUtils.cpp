@@ -27,6 +27,24 @@ void StringSplit(const string &str,
 	if(tmp.length() > 0) results->push_back(tmp);
 }
 
+// Same as above, but the results reference the characters of str instead of
+// copying them.
+void StringSplit(const StringPiece &str,
+		const StringPiece &delim,
+		vector<StringPiece> *results) {
+	size_t cutAt;
+	StringPiece tmp = str;
+	size_t len = delim.size();
+
+	while ((cutAt = tmp.find(delim)) != tmp.npos) {
+		if(cutAt > 0) {
+			results->push_back(tmp.substr(0,cutAt));
+		}
+		tmp = tmp.substr(cutAt+len);
+	}
+	if(tmp.length() > 0) results->push_back(tmp);
+}
+
 // Deletes any head in the string "line" after the first occurrence of any
 // non-delimiting character (e.g. whitespaces).
 void TrimLeft(const string &delim, string *line) {
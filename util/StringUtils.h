@@ -10,6 +10,7 @@
 
 #include <string>
 #include <vector>
+#include "StringPiece.h"
 
 using namespace std;
 
@@ -17,6 +18,10 @@ extern void StringSplit(const string &str,
                         const string &delim,
                         vector<string> *results);
 
+extern void StringSplit(const StringPiece &str,
+                        const StringPiece &delim,
+                        vector<StringPiece> *results);
+
 extern void TrimLeft(const string &delim, string *line);
 
 extern void TrimRight(const string &delim, string *line);
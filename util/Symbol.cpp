@@ -0,0 +1,54 @@
+/*
+ * Symbol.cpp
+ */
+
+#include "Symbol.h"
+
+namespace segparser {
+
+const string Symbol::emptyString;
+
+SymbolTable::SymbolTable() {
+	for (int i = 0; i < SYMBOL_SHARD_NUM; ++i)
+		pthread_mutex_init(&shards[i].mutex, NULL);
+}
+
+SymbolTable::~SymbolTable() {
+	for (int i = 0; i < SYMBOL_SHARD_NUM; ++i)
+		pthread_mutex_destroy(&shards[i].mutex);
+}
+
+Symbol SymbolTable::intern(const StringPiece& s) {
+	if (s.empty())
+		return Symbol();
+
+	size_t h = StringPieceHash()(s);
+	Shard& shard = shards[(h >> 32) % SYMBOL_SHARD_NUM];
+
+	pthread_mutex_lock(&shard.mutex);
+	const string* ret = NULL;
+	auto it = shard.map.find(s);
+	if (it != shard.map.end()) {
+		ret = it->second;
+	}
+	else {
+		shard.strings.push_back(s.toString());
+		ret = &shard.strings.back();
+		shard.map[StringPiece(*ret)] = ret;
+	}
+	pthread_mutex_unlock(&shard.mutex);
+
+	return Symbol(ret);
+}
+
+int SymbolTable::size() {
+	int size = 0;
+	for (int i = 0; i < SYMBOL_SHARD_NUM; ++i) {
+		pthread_mutex_lock(&shards[i].mutex);
+		size += shards[i].map.size();
+		pthread_mutex_unlock(&shards[i].mutex);
+	}
+	return size;
+}
+
+} /* namespace segparser */
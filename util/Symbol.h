@@ -0,0 +1,104 @@
+/*
+ * Symbol.h
+ */
+
+#ifndef SYMBOL_H_
+#define SYMBOL_H_
+
+#include <string>
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+#include <pthread.h>
+#include <stdint.h>
+#include "StringPiece.h"
+
+namespace segparser {
+
+using namespace std;
+
+class SymbolTable;
+
+// An interned string: a pointer into a SymbolTable, so copying a symbol
+// copies a pointer and nothing else. Symbols of the same table with the
+// same content are equal pointers; symbols of different tables must be
+// compared as strings. A symbol is valid as long as its table.
+// Converts to const string& wherever the string itself is needed.
+class Symbol {
+public:
+	Symbol() : str(&emptyString) {}
+
+	operator const string& () const { return *str; }
+	const string& toString() const { return *str; }
+
+	size_t size() const { return str->size(); }
+	bool empty() const { return str->empty(); }
+	const char* c_str() const { return str->c_str(); }
+	int compare(const string& s) const { return str->compare(s); }
+
+	bool operator == (const Symbol& s) const { return str == s.str; }
+	bool operator != (const Symbol& s) const { return str != s.str; }
+	bool operator == (const string& s) const { return *str == s; }
+	bool operator != (const string& s) const { return *str != s; }
+	bool operator == (const char* s) const { return *str == s; }
+	bool operator != (const char* s) const { return *str != s; }
+
+	friend string operator + (const string& a, const Symbol& b) { return a + *b.str; }
+	friend string operator + (const char* a, const Symbol& b) { return a + *b.str; }
+	friend string operator + (const Symbol& a, const string& b) { return *a.str + b; }
+	friend string operator + (const Symbol& a, const char* b) { return *a.str + b; }
+
+	friend ostream& operator << (ostream& os, const Symbol& s) {
+		os << *s.str;
+		return os;
+	}
+
+private:
+	friend class SymbolTable;
+	explicit Symbol(const string* s) : str(s) {}
+
+	const string* str;
+
+	static const string emptyString;		// of every table
+};
+
+struct StringPieceHash {
+	size_t operator() (const StringPiece& s) const {
+		uint64_t h = 14695981039346656037ULL;		// FNV-1a
+		for (size_t i = 0; i < s.size(); ++i) {
+			h ^= (unsigned char)s[i];
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+};
+
+// the table is split into shards with their own lock, so that the
+// parallel reader threads rarely wait for each other
+#define SYMBOL_SHARD_NUM 16
+
+// The strings of one corpus, or of one server request. Nothing is freed
+// before the table itself, which frees all its strings at once. Whoever
+// keeps the instances keeps the table, see DependencyReader::symbols.
+class SymbolTable {
+public:
+	SymbolTable();
+	virtual ~SymbolTable();
+
+	Symbol intern(const StringPiece& s);		// thread safe
+	int size();
+
+private:
+	struct Shard {
+		pthread_mutex_t mutex;
+		deque<string> strings;		// never moved, the keys and symbols point into them
+		unordered_map<StringPiece, const string*, StringPieceHash> map;
+	};
+	Shard shards[SYMBOL_SHARD_NUM];
+
+	SymbolTable(const SymbolTable&);
+	SymbolTable& operator = (const SymbolTable&);
+};
+
+} /* namespace segparser */
+#endif /* SYMBOL_H_ */